@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+    ChainFilter.cpp
+    Low cut, peak and high cut of both channels in one aligned block.
+
+  ==============================================================================
+*/
+
+#include "ChainFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // One sample through one section
+    inline float tick(const BiquadCoefficients& c, BiquadState& z, float x) {
+        const auto y = c.b0 * x + z[0];
+        z[0] = c.b1 * x - c.a1 * y + z[1];
+        z[1] = c.b2 * x - c.a2 * y;
+        return y;
+    }
+
+    // Every section in turn, unrolled by the fold
+    template<std::size_t... Sections>
+    inline float tickSections(const BiquadCoefficients* c, BiquadState* z, float x, std::index_sequence<Sections...>) {
+        ((x = tick(c[Sections], z[Sections], x)), ...);
+        return x;
+    }
+
+    bool isNeutral(const BiquadCoefficients& c) {
+        return c.b0 == 1.0f && c.b1 == c.a1 && c.b2 == c.a2;
+    }
+
+    // Samples until anything left in a section has decayed by 120 dB, from its largest pole radius
+    juce::int64 getRingSamples(const BiquadCoefficients& c) {
+        const auto a1 = (double)c.a1;
+        const auto a2 = (double)c.a2;
+        const auto discriminant = 0.25 * a1 * a1 - a2;
+        const auto radius = discriminant < 0.0 ? std::sqrt(a2)
+                                               : 0.5 * std::abs(a1) + std::sqrt(discriminant);
+        if (radius <= 0.0)
+            return 0;
+        if (radius >= 1.0)
+            return std::numeric_limits<juce::int64>::max();
+        return (juce::int64)std::ceil(std::log(1.0e-6) / std::log(radius));
+    }
+}
+
+//==============================================================================
+void processBiquads(const BiquadCoefficients* coefficients, BiquadState* state, int numSections, float* data, int numSamples) {
+    // Same recursion as juce::dsp::IIR::Filter, including flushing tiny state to zero
+    for (int s = 0; s < numSections; s++) {
+        const auto c = coefficients[s];
+        auto z0 = state[s][0];
+        auto z1 = state[s][1];
+        for (int i = 0; i < numSamples; i++) {
+            const auto x = data[i];
+            const auto y = c.b0 * x + z0;
+            z0 = c.b1 * x - c.a1 * y + z1;
+            z1 = c.b2 * x - c.a2 * y;
+            data[i] = y;
+        }
+        JUCE_SNAP_TO_ZERO(z0);
+        JUCE_SNAP_TO_ZERO(z1);
+        state[s] = {z0, z1};
+    }
+    return;
+}
+
+
+//==============================================================================
+void ChainFilter::reset() {
+    storage.state = {};
+    storage.peakActive = !storage.peakNeutral;
+    storage.peakRingSamples = 0;
+    return;
+}
+
+
+void ChainFilter::setCoefficients(const ChainCoefficients& coefficients) {
+    setCut(lowCutOffset, coefficients.lowCut, storage.numLowCut);
+    setCut(highCutOffset, coefficients.highCut, storage.numHighCut);
+    
+    // A skipped peak kept no state, it starts from silence like a new cut section. One that turns
+    // neutral still rings with what it holds, dropping that would click, so process() rings it out
+    // until its poles have decayed that by 120 dB and only then skips it.
+    storage.peakNeutral = isNeutral(coefficients.peak);
+    if (!storage.peakNeutral && !storage.peakActive) {
+        for (auto& channel : storage.state) {
+            channel[peakOffset] = {};
+        }
+        storage.peakActive = true;
+    }
+    if (!storage.peakNeutral)
+        storage.peakRingSamples = 0;
+    if (storage.peakNeutral && storage.peakActive) {
+        const auto isSilent = std::all_of(storage.state.begin(), storage.state.end(), [](const auto& channel) {
+            return channel[peakOffset] == BiquadState {};
+        });
+        if (isSilent)
+            storage.peakActive = false;
+        else
+            storage.peakRingSamples = juce::jmax(storage.peakRingSamples, getRingSamples(coefficients.peak));
+    }
+    storage.coefficients[peakOffset] = coefficients.peak;
+    return;
+}
+
+
+void ChainFilter::setCut(int offset, const CutCoefficients& cut, int& numActive) {
+    for (int i = 0; i < cut.numSections; i++) {
+        storage.coefficients[(size_t)(offset + i)] = cut[i];
+        if (i >= numActive) {
+            for (auto& channel : storage.state) {
+                channel[(size_t)(offset + i)] = {};
+            }
+        }
+    }
+    numActive = cut.numSections;
+    return;
+}
+
+
+void ChainFilter::process(float* const* channels, int numChannels, int numSamples) {
+    if (numChannels <= 0)
+        return;
+    
+    jassert(numChannels <= maxChannels);
+    numChannels = juce::jmin(numChannels, maxChannels);
+    if (storage.peakActive && storage.peakNeutral) {
+        processRingingPeak(channels, numChannels, numSamples);
+        return;
+    }
+    
+    const auto index = (((numChannels - 1) * numCutOrders + storage.numLowCut) * numCutOrders + storage.numHighCut) * 2
+                     + (storage.peakActive ? 1 : 0);
+    kernels[(size_t)index](storage, channels, numSamples);
+    return;
+}
+
+
+void ChainFilter::processRingingPeak(float* const* channels, int numChannels, int numSamples) {
+    // With the numerator equal to the denominator the input cancels out of the peak's recursion.
+    // Leaving it out keeps the float rounding of the input from feeding the resonance, so what
+    // is left after the ring time really is 120 dB down. Stage at a time, this only lasts a moment.
+    const auto& c = storage.coefficients[peakOffset];
+    for (int ch = 0; ch < numChannels; ch++) {
+        auto* data = channels[ch];
+        processLowCut(ch, data, numSamples);
+        auto& z = storage.state[(size_t)ch][peakOffset];
+        for (int i = 0; i < numSamples; i++) {
+            const auto z0 = z[0];
+            data[i] += z0;
+            z[0] = z[1] - c.a1 * z0;
+            z[1] = -c.a2 * z0;
+        }
+        JUCE_SNAP_TO_ZERO(z[0]);
+        JUCE_SNAP_TO_ZERO(z[1]);
+        processHighCut(ch, data, numSamples);
+    }
+    
+    storage.peakRingSamples -= numSamples;
+    if (storage.peakRingSamples <= 0) {
+        for (auto& channel : storage.state) {
+            channel[peakOffset] = {};
+        }
+        storage.peakActive = false;
+        storage.peakRingSamples = 0;
+    }
+    return;
+}
+
+
+void ChainFilter::processLowCut(int channel, float* data, int numSamples) {
+    processStage(channel, lowCutOffset, storage.numLowCut, data, numSamples);
+    return;
+}
+
+
+void ChainFilter::processPeak(int channel, float* data, int numSamples) {
+    processStage(channel, peakOffset, 1, data, numSamples);
+    return;
+}
+
+
+void ChainFilter::processHighCut(int channel, float* data, int numSamples) {
+    processStage(channel, highCutOffset, storage.numHighCut, data, numSamples);
+    return;
+}
+
+
+void ChainFilter::processStage(int channel, int offset, int numActive, float* data, int numSamples) {
+    jassert(channel >= 0 && channel < maxChannels);
+    processBiquads(storage.coefficients.data() + offset, storage.state[(size_t)channel].data() + offset, numActive, data, numSamples);
+    return;
+}
+
+
+//==============================================================================
+template<int NumChannels, int NumLowCut, int NumHighCut, bool PeakActive>
+void ChainFilter::processSpecialised(Storage& storage, float* const* channels, int numSamples) {
+    constexpr int numActive = NumLowCut + (PeakActive ? 1 : 0) + NumHighCut;
+    if constexpr (numActive > 0) {
+        // Slot in storage of the s-th section to run
+        constexpr auto slot = [](int s) {
+            if (s < NumLowCut)
+                return lowCutOffset + s;
+            if (PeakActive && s == NumLowCut)
+                return peakOffset;
+            return highCutOffset + s - NumLowCut - (PeakActive ? 1 : 0);
+        };
+        
+        // Dense local copies, so the unrolled sections index them with constants and the
+        // state can stay in registers for the whole block
+        std::array<BiquadCoefficients, numActive> c;
+        std::array<std::array<BiquadState, numActive>, NumChannels> z;
+        std::array<float*, NumChannels> data;
+        for (int s = 0; s < numActive; s++) {
+            c[(size_t)s] = storage.coefficients[(size_t)slot(s)];
+        }
+        for (int ch = 0; ch < NumChannels; ch++) {
+            data[(size_t)ch] = channels[ch];
+            for (int s = 0; s < numActive; s++) {
+                z[(size_t)ch][(size_t)s] = storage.state[(size_t)ch][(size_t)slot(s)];
+            }
+        }
+        
+        // Sample outer, so successive sections and the channels overlap in the pipeline
+        for (int i = 0; i < numSamples; i++) {
+            for (int ch = 0; ch < NumChannels; ch++) {
+                data[(size_t)ch][i] = tickSections(c.data(), z[(size_t)ch].data(), data[(size_t)ch][i], std::make_index_sequence<numActive>());
+            }
+        }
+        
+        for (int ch = 0; ch < NumChannels; ch++) {
+            for (int s = 0; s < numActive; s++) {
+                auto state = z[(size_t)ch][(size_t)s];
+                JUCE_SNAP_TO_ZERO(state[0]);
+                JUCE_SNAP_TO_ZERO(state[1]);
+                storage.state[(size_t)ch][(size_t)slot(s)] = state;
+            }
+        }
+    }
+    else {
+        juce::ignoreUnused(storage, channels, numSamples);
+    }
+    return;
+}
+
+
+template<std::size_t... Indices>
+constexpr std::array<ChainFilter::Kernel, sizeof...(Indices)> ChainFilter::makeKernels(std::index_sequence<Indices...>) {
+    // Same order as the index computed in process()
+    return {&processSpecialised<(int)(Indices / (2 * numCutOrders * numCutOrders)) + 1,
+                                (int)(Indices / (2 * numCutOrders) % numCutOrders),
+                                (int)(Indices / 2 % numCutOrders),
+                                Indices % 2 == 1>...};
+}
+
+
+const std::array<ChainFilter::Kernel, ChainFilter::numKernels> ChainFilter::kernels = makeKernels(std::make_index_sequence<numKernels>());
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    ChainFilter.h
+    Low cut, peak and high cut of both channels in one aligned block.
+
+    The coefficients are written once per design and read by both channels,
+    the filter state of each channel sits right behind them. processBlock
+    only ever touches this block, no Coefficients objects or state buffers
+    on the heap.
+
+    process() runs a kernel specialised at compile time for the channel
+    count, both cut orders and whether the peak is neutral, picked from a
+    function pointer table once per block. Its section loops are unrolled
+    and all sections of all channels advance one sample at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <utility>
+
+#include "EQDesign.h"
+
+
+// Jake: Two floats of transposed direct form II state per biquad section
+using BiquadState = std::array<float, 2>;
+
+// Jake: Runs numSections biquads in place over data, one section at a time
+void processBiquads(const BiquadCoefficients* coefficients, BiquadState* state, int numSections, float* data, int numSamples);
+
+
+// Jake: The whole EQ for up to maxChannels channels. Sections past the current cut orders keep
+// their slots, so raising the order never allocates and only the active sections are processed.
+class ChainFilter {
+public:
+    static constexpr int maxChannels = 2;
+
+    void reset();
+
+    // Writes all coefficients in place, cut sections that become active start from silence
+    void setCoefficients(const ChainCoefficients& coefficients);
+
+    // Whole chain on numChannels (1 or 2) channels through the specialised kernel
+    void process(float* const* channels, int numChannels, int numSamples);
+
+    // Jake: One stage at a time with the generic kernel, the reference the bench compares with
+    void processLowCut(int channel, float* data, int numSamples);
+    void processPeak(int channel, float* data, int numSamples);
+    void processHighCut(int channel, float* data, int numSamples);
+
+    // The peak is skipped by process() while its numerator equals its denominator (0 dB). A peak
+    // that turns neutral keeps running until its poles have rung out what it still holds.
+    bool isPeakActive() const { return storage.peakActive; }
+    bool isPeakRingingOut() const { return storage.peakActive && storage.peakNeutral; }
+
+private:
+    static constexpr int lowCutOffset = 0;
+    static constexpr int peakOffset = lowCutOffset + CutCoefficients::maxSections;
+    static constexpr int highCutOffset = peakOffset + 1;
+    static constexpr int numSections = highCutOffset + CutCoefficients::maxSections;
+
+    // Jake: Starts on a cache line so the coefficients and the state of the first channel share
+    // as few lines as possible with the rest of the processor
+    struct alignas(64) Storage {
+        std::array<BiquadCoefficients, numSections> coefficients {};
+        std::array<std::array<BiquadState, numSections>, maxChannels> state {};
+        int numLowCut = 0;
+        int numHighCut = 0;
+        bool peakActive = false;
+        bool peakNeutral = true;
+        juce::int64 peakRingSamples = 0;
+    };
+    Storage storage;
+
+    void setCut(int offset, const CutCoefficients& cut, int& numActive);
+    void processStage(int channel, int offset, int numActive, float* data, int numSamples);
+    void processRingingPeak(float* const* channels, int numChannels, int numSamples);
+
+    // Jake: One kernel per channel count, low cut order, high cut order and peak state
+    using Kernel = void (*)(Storage&, float* const*, int);
+    static constexpr int numCutOrders = CutCoefficients::maxSections + 1;
+    static constexpr int numKernels = maxChannels * numCutOrders * numCutOrders * 2;
+
+    template<int NumChannels, int NumLowCut, int NumHighCut, bool PeakActive>
+    static void processSpecialised(Storage& storage, float* const* channels, int numSamples);
+
+    template<std::size_t... Indices>
+    static constexpr std::array<Kernel, sizeof...(Indices)> makeKernels(std::index_sequence<Indices...>);
+
+    static const std::array<Kernel, numKernels> kernels;
+};
@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    Crossover.cpp
+    Linkwitz-Riley band splitter feeding the per-band output buses.
+
+  ==============================================================================
+*/
+
+#include "Crossover.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr std::array<Slope, NumCrossoverSlopes> crossoverOrders {Slope_12, Slope_24, Slope_48, Slope_96};
+}
+
+//==============================================================================
+CrossoverSplitCoefficients makeCrossoverSplit(CrossoverSlope slope, double frequency, double sampleRate) {
+    // Linkwitz-Riley of order 2N is the Butterworth of order N squared, both halves share its
+    // poles and sum to the allpass made from them
+    const auto order = crossoverOrders[(size_t)slope];
+    const auto halfOrder = (Slope)(((int)order + 1) / 2 - 1);
+    frequency = juce::jmin(frequency, 0.49 * sampleRate);
+
+    CrossoverSplitCoefficients split;
+    split.lowPass = makeCutFilter(false, CutType_LinkwitzRiley, order, frequency, sampleRate);
+    split.allPass = makeAllPassFilter(makeCutFilter(false, CutType_Butterworth, halfOrder, frequency, sampleRate));
+    return split;
+}
+
+
+void CascadeState::process(const CutCoefficients& coefficients, float* data, int numSamples) {
+    processBiquads(coefficients.sections.data(), state.data(), coefficients.numSections, data, numSamples);
+    return;
+}
+
+
+//==============================================================================
+void Crossover::prepare(double sampleRate, int maximumBlockSize) {
+    preparedSampleRate = sampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    bandBuffer.setSize(maxBands * maxChannels, maxBlockSize, false, true, true);
+    bandBuffer.clear();
+    numProcessedChannels = 0;
+    numProcessedSamples = 0;
+
+    design();
+    reset();
+    return;
+}
+
+
+void Crossover::release() {
+    bandBuffer.setSize(0, 0);
+    maxBlockSize = 0;
+    return;
+}
+
+
+void Crossover::reset() {
+    for (auto& state : channels) {
+        for (int i = 0; i < maxSplits; i++) {
+            state.lowPass[(size_t)i].reset();
+            state.allPass[(size_t)i].reset();
+            state.compensation[(size_t)i].reset();
+        }
+    }
+    return;
+}
+
+
+void Crossover::setRampLength(double stepsPerSecond, double rampLengthInSeconds) {
+    for (auto& frequency : frequencies) {
+        frequency.reset(stepsPerSecond, rampLengthInSeconds);
+    }
+    return;
+}
+
+
+void Crossover::setSettings(const CrossoverSettings& newSettings, bool snap) {
+    if (newSettings == target && !(snap && isSmoothing()))
+        return;
+
+    // The band tree is rebuilt for a new band count, state from the old one is meaningless
+    const auto bandsChanged = newSettings.numBands != settings.numBands;
+    const auto redesign = snap || bandsChanged || newSettings.slope != settings.slope;
+    target = newSettings;
+    for (int i = 0; i < maxSplits; i++) {
+        if (snap || bandsChanged)
+            frequencies[(size_t)i].setCurrentAndTargetValue(target.frequencies[(size_t)i]);
+        else
+            frequencies[(size_t)i].setTargetValue(target.frequencies[(size_t)i]);
+        settings.frequencies[(size_t)i] = frequencies[(size_t)i].getCurrentValue();
+    }
+    settings.numBands = target.numBands;
+    settings.slope = target.slope;
+
+    // A frequency change alone waits for the ramp
+    if (redesign)
+        design();
+    if (bandsChanged)
+        reset();
+    return;
+}
+
+
+void Crossover::advance() {
+    if (!isSmoothing())
+        return;
+
+    for (int i = 0; i < maxSplits; i++) {
+        settings.frequencies[(size_t)i] = frequencies[(size_t)i].getNextValue();
+    }
+    design();
+    return;
+}
+
+
+bool Crossover::isSmoothing() const {
+    return std::any_of(frequencies.begin(), frequencies.end(), [] (const auto& frequency) { return frequency.isSmoothing(); });
+}
+
+
+void Crossover::design() {
+    if (preparedSampleRate <= 0.0)
+        return;
+
+    const auto numSplits = juce::jlimit(0, maxSplits, settings.numBands - 1);
+    std::array<float, maxSplits> frequencies = settings.frequencies;
+    std::sort(frequencies.begin(), frequencies.begin() + numSplits);
+
+    for (int i = 0; i < numSplits; i++) {
+        splits[(size_t)i] = makeCrossoverSplit(settings.slope, frequencies[(size_t)i], preparedSampleRate);
+    }
+    return;
+}
+
+
+void Crossover::process(const juce::dsp::AudioBlock<const float>& input) {
+    numProcessedChannels = juce::jmin((int)input.getNumChannels(), maxChannels);
+    numProcessedSamples = (int)input.getNumSamples();
+    jassert(numProcessedSamples <= maxBlockSize);
+
+    const auto n = numProcessedSamples;
+    for (int ch = 0; ch < numProcessedChannels; ch++) {
+        auto& state = channels[(size_t)ch];
+        const auto* x = input.getChannelPointer((size_t)ch);
+        auto band = [this, ch](int b) { return bandBuffer.getWritePointer(b * maxChannels + ch); };
+
+        // Bands from different splits pick up the allpass of every split they didn't go
+        // through, so all of them sum back to the input with flat magnitude
+        switch (settings.numBands) {
+            case 2:
+                split(state, 0, x, band(0), band(1), n);
+                break;
+
+            case 3:
+                split(state, 0, x, band(0), band(2), n);
+                state.compensation[1].process(splits[1].allPass, band(0), n);
+                split(state, 1, band(2), band(1), band(2), n);
+                break;
+
+            case 4:
+                // Middle split first, then each half at its own frequency
+                split(state, 1, x, band(1), band(3), n);
+                state.compensation[2].process(splits[2].allPass, band(1), n);
+                state.compensation[0].process(splits[0].allPass, band(3), n);
+                split(state, 0, band(1), band(0), band(1), n);
+                split(state, 2, band(3), band(2), band(3), n);
+                break;
+
+            default:
+                juce::FloatVectorOperations::copy(band(0), x, n);
+                break;
+        }
+    }
+    return;
+}
+
+
+void Crossover::split(ChannelState& state, int index, const float* input, float* low, float* high, int numSamples) {
+    // The high band may replace its input, the low band is written before the input is touched
+    jassert(low != input);
+    const auto& coefficients = splits[(size_t)index];
+
+    juce::FloatVectorOperations::copy(low, input, numSamples);
+    state.lowPass[(size_t)index].process(coefficients.lowPass, low, numSamples);
+
+    if (high != input)
+        juce::FloatVectorOperations::copy(high, input, numSamples);
+    state.allPass[(size_t)index].process(coefficients.allPass, high, numSamples);
+    juce::FloatVectorOperations::subtract(high, low, numSamples);
+    return;
+}
+
+
+juce::dsp::AudioBlock<const float> Crossover::getBand(int band) const {
+    jassert(band >= 0 && band < maxBands);
+    return juce::dsp::AudioBlock<const float>(bandBuffer.getArrayOfReadPointers() + band * maxChannels,
+                                              (size_t)numProcessedChannels, (size_t)numProcessedSamples);
+}
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+    Linkwitz-Riley band splitter feeding the per-band output buses.
+
+    Each split runs the low pass of the crossover and the allpass both of
+    its halves sum to. The high band is the allpass minus the low band, so
+    the complementary band costs no filtering of its own, and the same
+    allpass design keeps the bands of the other splits phase aligned.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+#include "ChainFilter.h"
+#include "EQDesign.h"
+
+
+// Jake: Slope of the crossover filters, each half is a Butterworth of half the order squared
+enum CrossoverSlope {
+    CrossoverSlope_12,
+    CrossoverSlope_24,
+    CrossoverSlope_48,
+    CrossoverSlope_96,
+    NumCrossoverSlopes
+};
+
+
+// Jake: Struct for extracting the crossover settings from our parameters. Only the first
+// numBands - 1 frequencies are used, one band means the crossover is off.
+struct CrossoverSettings {
+    static constexpr int maxBands = 4;
+    int numBands = 1;
+    std::array<float, maxBands - 1> frequencies {200.0f, 2000.0f, 8000.0f};
+    CrossoverSlope slope = CrossoverSlope_24;
+
+    bool operator==(const CrossoverSettings& other) const = default;
+};
+
+
+// Jake: Designs of one split, sharing the poles of the Butterworth half
+struct CrossoverSplitCoefficients {
+    CutCoefficients lowPass;
+    CutCoefficients allPass;
+};
+
+CrossoverSplitCoefficients makeCrossoverSplit(CrossoverSlope slope, double frequency, double sampleRate);
+
+
+// Jake: Filter state for a cascade whose coefficients live elsewhere, transposed direct form II
+struct CascadeState {
+    std::array<BiquadState, CutCoefficients::maxSections> state {};
+
+    void reset() { state = {}; }
+    void process(const CutCoefficients& coefficients, float* data, int numSamples);
+};
+
+
+// Jake: Splits up to two channels into CrossoverSettings::maxBands bands. The band buffer is
+// allocated in prepare(), setSettings(), advance() and process() are audio thread safe.
+class Crossover {
+public:
+    static constexpr int maxBands = CrossoverSettings::maxBands;
+    static constexpr int maxChannels = 2;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void release();
+    void reset();
+
+    // Split frequencies ramp over rampLengthInSeconds, one step per call to advance()
+    void setRampLength(double stepsPerSecond, double rampLengthInSeconds);
+
+    // Band count and slope switch at once, frequencies ramp towards the new ones unless snap is
+    // set. A new band count restarts the filters from the new frequencies.
+    void setSettings(const CrossoverSettings& newSettings, bool snap);
+    int getNumBands() const { return settings.numBands; }
+
+    // One step of the frequency ramp, redesigning the splits while it moves
+    void advance();
+    bool isSmoothing() const;
+
+    // Splits at most the prepared block size into the band buffer
+    void process(const juce::dsp::AudioBlock<const float>& input);
+
+    // One band of the last processed block, with as many channels as its input
+    juce::dsp::AudioBlock<const float> getBand(int band) const;
+
+private:
+    static constexpr int maxSplits = maxBands - 1;
+
+    struct ChannelState {
+        std::array<CascadeState, maxSplits> lowPass, allPass, compensation;
+    };
+
+    void design();
+    void split(ChannelState& state, int index, const float* input, float* low, float* high, int numSamples);
+
+    CrossoverSettings settings, target;
+    std::array<juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>, maxSplits> frequencies;
+    double preparedSampleRate = 0.0;
+    int maxBlockSize = 0;
+    int numProcessedChannels = 0;
+    int numProcessedSamples = 0;
+
+    // Ascending split frequencies, splits[i] is the boundary above band i
+    std::array<CrossoverSplitCoefficients, maxSplits> splits;
+    std::array<ChannelState, maxChannels> channels;
+    juce::AudioBuffer<float> bandBuffer;    // maxBands * maxChannels channels, band major
+};
@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    EQDesign.cpp
+    Settings and coefficient design for the SimpleEQ filters.
+
+    The peak formula matches juce::dsp::IIR::Coefficients. Cut filters are
+    designed from analog prototypes (Butterworth, Linkwitz-Riley, Bessel and
+    Chebyshev) that are computed once and cached, then mapped with the
+    bilinear transform. Everything writes into fixed-size structs instead of
+    allocating new Coefficients objects.
+
+  ==============================================================================
+*/
+
+#include "EQDesign.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+    BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) {
+        const auto invA0 = 1.0 / a0;
+        BiquadCoefficients coefficients;
+        coefficients.b0 = float(b0 * invA0);
+        coefficients.b1 = float(b1 * invA0);
+        coefficients.b2 = float(b2 * invA0);
+        coefficients.a1 = float(a1 * invA0);
+        coefficients.a2 = float(a2 * invA0);
+        return coefficients;
+    }
+    
+    // Jake: Section of an analog low pass prototype with its cutoff at 1 rad/s, b / (s^2 + a s + b).
+    // First order sections are b / (s + b).
+    struct AnalogSection {
+        bool isFirstOrder = false;
+        double a = 0.0;
+        double b = 1.0;
+    };
+    
+    struct AnalogPrototype {
+        std::array<AnalogSection, CutCoefficients::maxSections> sections;
+        int numSections = 0;
+        double gain = 1.0;
+        
+        void addPole(std::complex<double> pole) {
+            // One section per conjugate pair, poles in the lower half plane are skipped
+            if (std::abs(pole.imag()) < 1.0e-9)
+                sections[(size_t)numSections++] = {true, 0.0, -pole.real()};
+            else if (pole.imag() > 0.0)
+                sections[(size_t)numSections++] = {false, -2.0 * pole.real(), std::norm(pole)};
+        }
+    };
+    
+    constexpr int maxOrder = 2 * CutCoefficients::maxSections;
+    constexpr double chebyshevRippleDecibels = 1.0;
+    
+    AnalogPrototype makeButterworthPrototype(int order) {
+        AnalogPrototype prototype;
+        for (int k = 0; k < order; k++) {
+            const auto angle = juce::MathConstants<double>::pi * (2.0 * k + order + 1.0) / (2.0 * order);
+            prototype.addPole(std::polar(1.0, angle));
+        }
+        return prototype;
+    }
+    
+    AnalogPrototype makeLinkwitzRileyPrototype(int order) {
+        // Two identical Butterworth filters of half the order, -6 dB at the cutoff
+        auto prototype = makeButterworthPrototype(juce::jmax(1, (order + 1) / 2));
+        const auto half = prototype.numSections;
+        for (int i = 0; i < half; i++) {
+            prototype.sections[(size_t)prototype.numSections++] = prototype.sections[(size_t)i];
+        }
+        return prototype;
+    }
+    
+    AnalogPrototype makeChebyshevPrototype(int order) {
+        const auto epsilon = std::sqrt(std::pow(10.0, chebyshevRippleDecibels / 10.0) - 1.0);
+        const auto mu = std::asinh(1.0 / epsilon) / order;
+        
+        AnalogPrototype prototype;
+        for (int k = 0; k < order; k++) {
+            const auto theta = juce::MathConstants<double>::pi * (2.0 * k + 1.0) / (2.0 * order);
+            prototype.addPole({-std::sinh(mu) * std::sin(theta), std::cosh(mu) * std::cos(theta)});
+        }
+        // Even orders start the passband at the bottom of the ripple
+        if (order % 2 == 0)
+            prototype.gain = 1.0 / std::sqrt(1.0 + epsilon * epsilon);
+        return prototype;
+    }
+    
+    AnalogPrototype makeBesselPrototype(int order) {
+        // Reverse Bessel polynomial, c_k = (2n - k)! / (2^(n - k) k! (n - k)!), c_n = 1
+        std::array<double, maxOrder + 1> c {};
+        for (int k = 0; k <= order; k++) {
+            c[(size_t)k] = std::exp(std::lgamma(2.0 * order - k + 1.0) - (order - k) * std::log(2.0)
+                                    - std::lgamma(k + 1.0) - std::lgamma(order - k + 1.0));
+        }
+        auto evaluate = [&](std::complex<double> s) {
+            std::complex<double> result = c[(size_t)order];
+            for (int k = order - 1; k >= 0; k--) {
+                result = result * s + c[(size_t)k];
+            }
+            return result;
+        };
+        
+        // Durand-Kerner, started on a spiral with the radius of the roots' geometric mean
+        std::array<std::complex<double>, maxOrder> roots {};
+        const auto radius = std::pow(c[0], 1.0 / order);
+        for (int i = 0; i < order; i++) {
+            roots[(size_t)i] = radius * std::pow(std::complex<double>(0.4, 0.9), i);
+        }
+        for (int iteration = 0; iteration < 500; iteration++) {
+            for (int i = 0; i < order; i++) {
+                std::complex<double> denominator = 1.0;
+                for (int j = 0; j < order; j++) {
+                    if (j != i)
+                        denominator *= roots[(size_t)i] - roots[(size_t)j];
+                }
+                roots[(size_t)i] -= evaluate(roots[(size_t)i]) / denominator;
+            }
+        }
+        
+        // Rescale from unit group delay to -3 dB at 1 rad/s
+        double low = 0.0;
+        double high = 4.0 * order;
+        for (int iteration = 0; iteration < 100; iteration++) {
+            const auto omega = 0.5 * (low + high);
+            const auto magnitude = c[0] / std::abs(evaluate({0.0, omega}));
+            if (magnitude * magnitude > 0.5)
+                low = omega;
+            else
+                high = omega;
+        }
+        
+        AnalogPrototype prototype;
+        for (int i = 0; i < order; i++) {
+            prototype.addPole(roots[(size_t)i] / (0.5 * (low + high)));
+        }
+        return prototype;
+    }
+    
+    // Jake: Every prototype is computed once, on first use, and only read afterwards. Sections are
+    // sorted by rising Q so the cascade's internal gain stays low.
+    const AnalogPrototype& getPrototype(CutType type, int order) {
+        using Table = std::array<std::array<AnalogPrototype, maxOrder>, NumCutTypes>;
+        static const Table table = [] {
+            Table prototypes;
+            for (int order = 1; order <= maxOrder; order++) {
+                prototypes[CutType_Butterworth][(size_t)order - 1] = makeButterworthPrototype(order);
+                prototypes[CutType_LinkwitzRiley][(size_t)order - 1] = makeLinkwitzRileyPrototype(order);
+                prototypes[CutType_Bessel][(size_t)order - 1] = makeBesselPrototype(order);
+                prototypes[CutType_Chebyshev][(size_t)order - 1] = makeChebyshevPrototype(order);
+            }
+            for (auto& row : prototypes) {
+                for (auto& prototype : row) {
+                    std::sort(prototype.sections.begin(), prototype.sections.begin() + prototype.numSections,
+                              [](const AnalogSection& x, const AnalogSection& y) {
+                                  const auto qx = x.isFirstOrder ? 0.0 : std::sqrt(x.b) / x.a;
+                                  const auto qy = y.isFirstOrder ? 0.0 : std::sqrt(y.b) / y.a;
+                                  return qx < qy;
+                              });
+                }
+            }
+            return prototypes;
+        }();
+        return table[(size_t)type][(size_t)juce::jlimit(1, maxOrder, order) - 1];
+    }
+    
+    // Bilinear transform of one prototype section, k = tan(pi f / fs) prewarps the cutoff
+    BiquadCoefficients makeDigitalSection(const AnalogSection& section, bool isHighPass, double k) {
+        if (section.isFirstOrder) {
+            // s -> 1 / s turns b / (s + b) into s / (s + 1 / b)
+            const auto ck = (isHighPass ? 1.0 / section.b : section.b) * k;
+            return isHighPass ? normalise(1, -1, 0, 1 + ck, ck - 1, 0)
+                              : normalise(ck, ck, 0, 1 + ck, ck - 1, 0);
+        }
+        
+        // s -> 1 / s turns b / (s^2 + a s + b) into s^2 / (s^2 + (a / b) s + 1 / b)
+        const auto a = isHighPass ? section.a / section.b : section.a;
+        const auto b = isHighPass ? 1.0 / section.b : section.b;
+        const auto bkk = b * k * k;
+        const auto a0 = 1 + a * k + bkk;
+        const auto a1 = 2 * (bkk - 1);
+        const auto a2 = 1 - a * k + bkk;
+        return isHighPass ? normalise(1, -2, 1, a0, a1, a2)
+                          : normalise(bkk, 2 * bkk, bkk, a0, a1, a2);
+    }
+}
+
+//==============================================================================
+BiquadCoefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate) {
+    const auto gainFactor = juce::Decibels::decibelsToGain((double)chainSettings.peakGainInDecibels);
+    const auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+    const auto omega = (2 * juce::MathConstants<double>::pi * juce::jmax((double)chainSettings.peakFreq, 2.0)) / sampleRate;
+    const auto alpha = std::sin(omega) / (chainSettings.peakQuality * 2.0);
+    const auto c2 = -2 * std::cos(omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+    return normalise(1 + alphaTimesA, c2, 1 - alphaTimesA, 1 + alphaOverA, c2, 1 - alphaOverA);
+}
+
+
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate) {
+    return makeCutFilter(true, chainSettings.lowCutType, chainSettings.lowCutSlope, chainSettings.lowCutFreq, sampleRate);
+}
+
+
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate) {
+    return makeCutFilter(false, chainSettings.highCutType, chainSettings.highCutSlope, chainSettings.highCutFreq, sampleRate);
+}
+
+
+CutCoefficients makeCutFilter(bool isHighPass, CutType type, Slope slope, double frequency, double sampleRate) {
+    const auto& prototype = getPrototype(type, (int)slope + 1);
+    const auto k = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    
+    CutCoefficients cut;
+    for (int i = 0; i < prototype.numSections; i++) {
+        cut.sections[(size_t)i] = makeDigitalSection(prototype.sections[(size_t)i], isHighPass, k);
+    }
+    cut.numSections = prototype.numSections;
+    
+    // Passband gain of the prototype goes on the first section
+    if (prototype.gain != 1.0) {
+        cut.sections[0].b0 *= (float)prototype.gain;
+        cut.sections[0].b1 *= (float)prototype.gain;
+        cut.sections[0].b2 *= (float)prototype.gain;
+    }
+    return cut;
+}
+
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate) {
+    ChainCoefficients coefficients;
+    coefficients.peak = makePeakFilter(chainSettings, sampleRate);
+    coefficients.lowCut = makeLowCutFilter(chainSettings, sampleRate);
+    coefficients.highCut = makeHighCutFilter(chainSettings, sampleRate);
+    return coefficients;
+}
+
+
+CutCoefficients makeAllPassFilter(const CutCoefficients& cut) {
+    // Each section keeps its denominator and takes the reversed denominator as numerator
+    CutCoefficients allPass;
+    for (int i = 0; i < cut.numSections; i++) {
+        const auto& section = cut[i];
+        const auto isFirstOrder = section.a2 == 0.0f && section.b2 == 0.0f;
+        auto& target = allPass.sections[(size_t)i];
+        target.b0 = isFirstOrder ? section.a1 : section.a2;
+        target.b1 = isFirstOrder ? 1.0f : section.a1;
+        target.b2 = isFirstOrder ? 0.0f : 1.0f;
+        target.a1 = section.a1;
+        target.a2 = section.a2;
+    }
+    allPass.numSections = cut.numSections;
+    return allPass;
+}
+
+
+std::array<BiquadCoefficients, 2> makeKWeightingFilter(double sampleRate) {
+    // Designed for any rate from the analog prototypes (as in libebur128), the tables in
+    // BS.1770 are only given for 48 kHz
+    std::array<BiquadCoefficients, 2> filter;
+
+    {
+        const double f0 = 1681.974450955533;
+        const double gain = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gain / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        filter[0] = normalise(vh + vb * k / q + k * k, 2.0 * (k * k - vh), vh - vb * k / q + k * k,
+                              a0, 2.0 * (k * k - 1.0), 1.0 - k / q + k * k);
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        // The numerator stays (1, -2, 1) unscaled like libebur128's, LevelMeter folds it in
+        filter[1] = normalise(1.0, -2.0, 1.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0);
+    }
+
+    return filter;
+}
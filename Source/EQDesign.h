@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    EQDesign.h
+    Settings and coefficient design for the SimpleEQ filters.
+
+    Everything here is plain math on fixed-size structs: no allocation, no
+    JUCE DSP objects, so it can run on the audio thread or outside the plugin.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+
+// Jake: Enum representing slope order, Slope_N is a filter of order N / 6
+enum Slope {
+    Slope_6,
+    Slope_12,
+    Slope_18,
+    Slope_24,
+    Slope_30,
+    Slope_36,
+    Slope_42,
+    Slope_48,
+    Slope_54,
+    Slope_60,
+    Slope_66,
+    Slope_72,
+    Slope_78,
+    Slope_84,
+    Slope_90,
+    Slope_96,
+    NumSlopes
+};
+
+
+// Jake: Enum representing the response shape of a cut filter
+enum CutType {
+    CutType_Butterworth,
+    CutType_LinkwitzRiley,     // odd orders are rounded up to the next even order
+    CutType_Bessel,            // -3 dB at the cutoff
+    CutType_Chebyshev,         // 1 dB passband ripple, -1 dB at the cutoff
+    NumCutTypes
+};
+
+
+// Jake: Struct for extracting settings from our parameters
+struct ChainSettings {
+    float peakFreq = 0;
+    float peakGainInDecibels = 0;
+    float peakQuality = 0;
+    float lowCutFreq = 0;
+    float highCutFreq = 0;
+    Slope lowCutSlope = Slope::Slope_12;
+    Slope highCutSlope = Slope::Slope_12;
+    CutType lowCutType = CutType::CutType_Butterworth;
+    CutType highCutType = CutType::CutType_Butterworth;
+    
+    bool operator==(const ChainSettings& other) const = default;
+};
+
+
+// Jake: Normalised biquad, a0 is always 1. First order sections leave b2 and a2 at 0.
+struct BiquadCoefficients {
+    float b0 = 1;
+    float b1 = 0;
+    float b2 = 0;
+    float a1 = 0;
+    float a2 = 0;
+};
+
+
+// Jake: Sections of a cut filter, one per active section of CutFilter. Enough for order 16.
+struct CutCoefficients {
+    static constexpr int maxSections = 8;
+    std::array<BiquadCoefficients, maxSections> sections;
+    int numSections = 0;
+    
+    const BiquadCoefficients& operator[](int index) const { return sections[(size_t)index]; }
+};
+
+
+// Jake: Everything designed for one ChainSettings at one sample rate
+struct ChainCoefficients {
+    BiquadCoefficients peak;
+    CutCoefficients lowCut;
+    CutCoefficients highCut;
+};
+
+
+BiquadCoefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate);
+// Jake: Designs any cut from the cached analog prototype of its type and order
+CutCoefficients makeCutFilter(bool isHighPass, CutType type, Slope slope, double frequency, double sampleRate);
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+// Jake: Allpass with the poles of a cut filter. For a Butterworth cut of order N it is the sum of
+// the low and high pass of the Linkwitz-Riley crossover of order 2N at the same frequency.
+CutCoefficients makeAllPassFilter(const CutCoefficients& cut);
+
+// Jake: K-weighting pre-filter of ITU-R BS.1770, a high shelf followed by a high pass
+std::array<BiquadCoefficients, 2> makeKWeightingFilter(double sampleRate);
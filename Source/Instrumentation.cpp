@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Instrumentation.cpp
+    Lightweight audio-thread instrumentation for SimpleEQ.
+
+  ==============================================================================
+*/
+
+#include "Instrumentation.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Per thread, so a block only ever sees what its own thread allocated
+    thread_local int audioThreadDepth = 0;
+    thread_local juce::uint64 audioThreadAllocations = 0;
+    
+    juce::uint64 ticksToNanoseconds(juce::uint64 ticks) {
+        return (juce::uint64)(1.0e9 * (double)ticks / (double)juce::Time::getHighResolutionTicksPerSecond());
+    }
+}
+
+//==============================================================================
+double ProcessorStats::Snapshot::getAverageBlockSeconds() const {
+    if (numBlocks == 0)
+        return 0.0;
+    return 1.0e-9 * (double)ticksToNanoseconds(totalBlockTicks) / (double)numBlocks;
+}
+
+double ProcessorStats::Snapshot::getMaxBlockSeconds() const {
+    return 1.0e-9 * (double)ticksToNanoseconds(maxBlockTicks);
+}
+
+void ProcessorStats::addBlock(juce::uint64 ticks, juce::uint64 allocations) {
+    add(numBlocks, 1);
+    add(totalBlockTicks, ticks);
+    if (maxBlockResetRequested.exchange(false, std::memory_order_relaxed)
+        || ticks > maxBlockTicks.load(std::memory_order_relaxed))
+        maxBlockTicks.store(ticks, std::memory_order_relaxed);
+    if (allocations > 0)
+        add(audioThreadAllocations, allocations);
+    return;
+}
+
+ProcessorStats::Snapshot ProcessorStats::getSnapshot() const {
+    Snapshot snapshot;
+    for (int i = 0; i < NumProcessStages; i++) {
+        snapshot.stageTicks[i] = stageTicks[i].load(std::memory_order_relaxed);
+    }
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    snapshot.totalBlockTicks = totalBlockTicks.load(std::memory_order_relaxed);
+    snapshot.maxBlockTicks = maxBlockTicks.load(std::memory_order_relaxed);
+    snapshot.coefficientRebuilds = coefficientRebuilds.load(std::memory_order_relaxed);
+    snapshot.audioThreadAllocations = audioThreadAllocations.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+//==============================================================================
+juce::uint64 getAudioThreadAllocationCount() {
+    return audioThreadAllocations;
+}
+
+AudioThreadScope::AudioThreadScope() {
+    ++audioThreadDepth;
+}
+
+AudioThreadScope::~AudioThreadScope() {
+    --audioThreadDepth;
+}
+
+//==============================================================================
+#if SIMPLEEQ_INSTRUMENTATION
+// Jake: Replacement global allocation functions that count allocations made inside
+// an AudioThreadScope. This is for profiling builds only, it replaces operator new
+// for the whole binary the plugin is linked into.
+static void* countedAllocation(std::size_t size) {
+    if (audioThreadDepth > 0)
+        ++audioThreadAllocations;
+    
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocation(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocation(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    Instrumentation.h
+    Lightweight audio-thread instrumentation for SimpleEQ.
+
+    Build with SIMPLEEQ_INSTRUMENTATION=1 to enable it. When disabled the
+    timing macros compile to nothing and the stats stay at zero.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+
+#ifndef SIMPLEEQ_INSTRUMENTATION
+ #define SIMPLEEQ_INSTRUMENTATION 0
+#endif
+
+
+// Jake: Stages of processBlock that get their own counters
+enum ProcessStage {
+    StageCoefficients,
+    StageLowCut,
+    StagePeak,
+    StageHighCut,
+    StageInputMeter,
+    StageOutputMeter,
+    StageCrossover,
+    StageSoftClip,
+    NumProcessStages
+};
+
+
+// Jake: Lock-free stats written by the audio thread only. Any thread may read them
+// through getSnapshot(), values are accumulated ticks of juce::Time::getHighResolutionTicks().
+struct ProcessorStats {
+    struct Snapshot {
+        std::array<juce::uint64, NumProcessStages> stageTicks {};
+        juce::uint64 numBlocks = 0;
+        juce::uint64 totalBlockTicks = 0;
+        juce::uint64 maxBlockTicks = 0;
+        juce::uint64 coefficientRebuilds = 0;
+        juce::uint64 audioThreadAllocations = 0;
+        
+        double getAverageBlockSeconds() const;
+        double getMaxBlockSeconds() const;
+    };
+    
+    void addStageTicks(ProcessStage stage, juce::uint64 ticks) { add(stageTicks[stage], ticks); }
+    void addBlock(juce::uint64 ticks, juce::uint64 allocations);
+    void addCoefficientRebuild() { add(coefficientRebuilds, 1); }
+    
+    Snapshot getSnapshot() const;
+    
+    // Jake: Any thread may ask for this, the audio thread applies it at the next block so the
+    // maximum keeps a single writer
+    void resetMaxBlockTicks() { maxBlockResetRequested.store(true, std::memory_order_relaxed); }
+    
+private:
+    std::array<std::atomic<juce::uint64>, NumProcessStages> stageTicks {};
+    std::atomic<juce::uint64> numBlocks {0};
+    std::atomic<juce::uint64> totalBlockTicks {0};
+    std::atomic<juce::uint64> maxBlockTicks {0};
+    std::atomic<juce::uint64> coefficientRebuilds {0};
+    std::atomic<juce::uint64> audioThreadAllocations {0};
+    std::atomic<bool> maxBlockResetRequested {false};
+    
+    // Single writer, so a relaxed load/store pair is enough and avoids a locked RMW
+    static void add(std::atomic<juce::uint64>& counter, juce::uint64 amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+
+// Jake: Number of heap allocations the calling thread made while one of its AudioThreadScopes was
+// active. Allocations on other threads never show up here. Only counts when SIMPLEEQ_INSTRUMENTATION
+// replaces the global operator new.
+juce::uint64 getAudioThreadAllocationCount();
+
+struct AudioThreadScope {
+    AudioThreadScope();
+    ~AudioThreadScope();
+};
+
+
+// Jake: Times a single stage of the block
+struct ScopedStageTimer {
+    ScopedStageTimer(ProcessorStats& s, ProcessStage st)
+        : stats(s), stage(st), start(juce::Time::getHighResolutionTicks()) {}
+    ~ScopedStageTimer() {
+        stats.addStageTicks(stage, (juce::uint64)(juce::Time::getHighResolutionTicks() - start));
+    }
+    
+private:
+    ProcessorStats& stats;
+    ProcessStage stage;
+    juce::int64 start;
+};
+
+
+// Jake: Times a whole processBlock call and counts any allocations made during it
+struct ScopedBlockTimer {
+    explicit ScopedBlockTimer(ProcessorStats& s)
+        : stats(s), allocationsAtStart(getAudioThreadAllocationCount()), start(juce::Time::getHighResolutionTicks()) {}
+    ~ScopedBlockTimer() {
+        auto ticks = (juce::uint64)(juce::Time::getHighResolutionTicks() - start);
+        auto allocations = getAudioThreadAllocationCount() - allocationsAtStart;
+        stats.addBlock(ticks, allocations);
+        
+        // Something in processBlock went to the heap, break here to find out what
+        jassert(allocations == 0);
+    }
+    
+private:
+    ProcessorStats& stats;
+    AudioThreadScope audioThreadScope;
+    juce::uint64 allocationsAtStart;
+    juce::int64 start;
+};
+
+
+#if SIMPLEEQ_INSTRUMENTATION
+ #define SIMPLEEQ_BLOCK_TIMER(stats)          ScopedBlockTimer JUCE_JOIN_MACRO(simpleEQBlockTimer_, __LINE__) (stats)
+ #define SIMPLEEQ_STAGE_TIMER(stats, stage)   ScopedStageTimer JUCE_JOIN_MACRO(simpleEQStageTimer_, __LINE__) (stats, stage)
+ #define SIMPLEEQ_COUNT_REBUILD(stats)        (stats).addCoefficientRebuild()
+#else
+ #define SIMPLEEQ_BLOCK_TIMER(stats)
+ #define SIMPLEEQ_STAGE_TIMER(stats, stage)
+ #define SIMPLEEQ_COUNT_REBUILD(stats)
+#endif
@@ -0,0 +1,405 @@
+/*
+  ==============================================================================
+
+    LatencyRig.cpp
+    Headless host for the Standalone target, times every audio callback.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+// Only the Standalone app runs the rig, the other formats don't build it
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include "LatencyRig.h"
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+namespace {
+    constexpr int numDeviceChannels = 2;
+
+    double nowMs() {
+        return juce::Time::getMillisecondCounterHiRes();
+    }
+}
+
+//==============================================================================
+// Jake: Stands in for a device clock. Callbacks are due every period from the start of the run,
+// a callback that overruns the next period too is an xrun and the lost periods are dropped,
+// like a real device would.
+class LatencyRig::PacedDevice : public juce::Thread {
+public:
+    PacedDevice(LatencyRig& r, int bufferSize, int numCallbacks)
+        : juce::Thread("SimpleEQ paced device"), rig(r), numCallbacksToRun(numCallbacks) {
+        input.setSize(numDeviceChannels, bufferSize);
+        output.setSize(numDeviceChannels, bufferSize);
+        input.clear();
+    }
+
+    ~PacedDevice() override {
+        stopThread(2000);
+    }
+
+    int getXRuns() const { return xruns.load(); }
+
+private:
+    void run() override {
+        const auto periodMs = rig.periodMs;
+        const auto bufferSize = input.getNumSamples();
+        auto scheduledMs = rig.runStartMs.load();
+
+        for (int i = 0; i < numCallbacksToRun && !threadShouldExit(); i++) {
+            waitUntil(scheduledMs);
+            readInput(bufferSize);
+            rig.process(input.getArrayOfReadPointers(), numDeviceChannels, output.getArrayOfWritePointers(), numDeviceChannels, bufferSize, scheduledMs);
+            writeOutput(bufferSize);
+
+            scheduledMs += periodMs;
+            const auto lateMs = nowMs() - scheduledMs;
+            if (lateMs > periodMs) {
+                const auto lostPeriods = std::floor(lateMs / periodMs);
+                scheduledMs += lostPeriods * periodMs;
+                xruns++;
+            }
+        }
+        rig.isDone.store(true);
+        return;
+    }
+
+    void waitUntil(double targetMs) {
+        // Sleep most of the way, then spin for the last stretch so the wake up is precise
+        for (auto remaining = targetMs - nowMs(); remaining > 0.0; remaining = targetMs - nowMs()) {
+            if (remaining > 2.0)
+                juce::Thread::sleep((int)(remaining - 1.5));
+            else
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    void readInput(int numSamples) {
+        // File device loops its preloaded input, the null device stays silent
+        const auto length = rig.inputAudio.getNumSamples();
+        if (length == 0)
+            return;
+
+        for (int offset = 0; offset < numSamples;) {
+            const auto count = juce::jmin(numSamples - offset, length - rig.inputPosition);
+            for (int ch = 0; ch < numDeviceChannels; ch++) {
+                input.copyFrom(ch, offset, rig.inputAudio, juce::jmin(ch, rig.inputAudio.getNumChannels() - 1), rig.inputPosition, count);
+            }
+            offset += count;
+            rig.inputPosition = (rig.inputPosition + count) % length;
+        }
+        return;
+    }
+
+    void writeOutput(int numSamples) {
+        const auto count = juce::jmin(numSamples, rig.outputAudio.getNumSamples() - rig.outputPosition);
+        if (count <= 0)
+            return;
+
+        for (int ch = 0; ch < numDeviceChannels; ch++) {
+            rig.outputAudio.copyFrom(ch, rig.outputPosition, output, ch, 0, count);
+        }
+        rig.outputPosition += count;
+        return;
+    }
+
+    LatencyRig& rig;
+    const int numCallbacksToRun;
+    juce::AudioBuffer<float> input, output;
+    std::atomic<int> xruns {0};
+};
+
+
+//==============================================================================
+LatencyRig::Options LatencyRig::Options::fromArguments(const juce::ArgumentList& args) {
+    Options options;
+    if (args.containsOption("--device"))
+        options.device = args.getValueForOption("--device");
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--buffer"))
+        options.bufferSize = args.getValueForOption("--buffer").getIntValue();
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+    if (args.containsOption("--input"))
+        options.input = args.getFileForOption("--input");
+    if (args.containsOption("--output"))
+        options.output = args.getFileForOption("--output");
+    if (args.containsOption("--state"))
+        options.state = args.getFileForOption("--state");
+    if (args.containsOption("--log"))
+        options.log = args.getFileForOption("--log");
+    if (args.containsOption("--trace"))
+        options.trace = args.getFileForOption("--trace");
+    return options;
+}
+
+
+LatencyRig::LatencyRig(const Options& o) : options(o) {
+}
+
+
+LatencyRig::~LatencyRig() {
+    stopTimer();
+    pacedDevice = nullptr;
+    deviceManager.removeAudioCallback(this);
+    deviceManager.closeAudioDevice();
+}
+
+
+void LatencyRig::start(std::function<void(int)> finished) {
+    onFinished = std::move(finished);
+
+    if (options.sampleRate <= 0.0 || options.bufferSize <= 0 || options.seconds <= 0.0) {
+        fail("Invalid --rate, --buffer or --seconds");
+        return;
+    }
+
+    processor = std::make_unique<SimpleEQAudioProcessor>();
+    if (options.state != juce::File()) {
+        juce::MemoryBlock state;
+        if (!options.state.loadFileAsData(state)) {
+            fail("Can't read state " + options.state.getFullPathName());
+            return;
+        }
+        processor->setStateInformation(state.getData(), (int)state.getSize());
+    }
+    if (options.trace != juce::File()) {
+        auto& recorder = static_cast<SimpleEQAudioProcessor&>(*processor).getTraceRecorder();
+        if (!recorder.start(options.trace)) {
+            fail("Can't write trace " + options.trace.getFullPathName());
+            return;
+        }
+    }
+
+    // Null and file devices are paced by our own thread at exactly the requested settings
+    if (options.device == "null" || options.device == "file") {
+        if (options.device == "file") {
+            juce::AudioFormatManager formats;
+            formats.registerBasicFormats();
+            std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(options.input));
+            if (reader == nullptr || reader->lengthInSamples <= 0) {
+                fail("Can't read input " + options.input.getFullPathName());
+                return;
+            }
+            inputAudio.setSize((int)juce::jmin(reader->numChannels, (unsigned int)numDeviceChannels), (int)reader->lengthInSamples);
+            reader->read(&inputAudio, 0, inputAudio.getNumSamples(), 0, true, true);
+        }
+
+        prepare(options.sampleRate, options.bufferSize);
+        pacedDevice = std::make_unique<PacedDevice>(*this, options.bufferSize, expectedCallbacks);
+        runStartMs.store(nowMs() + periodMs);
+        pacedDevice->startThread(juce::Thread::Priority::highest);
+        startTimer(50);
+        return;
+    }
+
+    // Anything else is a device type, opened on its default device with the requested settings
+    deviceManager.getAvailableDeviceTypes();
+    deviceManager.setCurrentAudioDeviceType(options.device, true);
+    auto* type = deviceManager.getCurrentDeviceTypeObject();
+    if (type == nullptr || type->getTypeName() != options.device) {
+        fail("Unknown audio device type " + options.device);
+        return;
+    }
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.sampleRate = options.sampleRate;
+    setup.bufferSize = options.bufferSize;
+    setup.useDefaultInputChannels = false;
+    setup.useDefaultOutputChannels = false;
+    setup.inputChannels.clear();
+    setup.inputChannels.setRange(0, numDeviceChannels, true);
+    setup.outputChannels.clear();
+    setup.outputChannels.setRange(0, numDeviceChannels, true);
+    const auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    if (error.isNotEmpty() || deviceManager.getCurrentAudioDevice() == nullptr) {
+        fail("Can't open " + options.device + " device: " + error);
+        return;
+    }
+
+    deviceManager.addAudioCallback(this);
+    startTimer(50);
+    return;
+}
+
+
+void LatencyRig::prepare(double sampleRate, int bufferSize) {
+    expectedCallbacks = juce::jmax(1, (int)std::ceil(options.seconds * sampleRate / bufferSize));
+    periodMs = 1000.0 * bufferSize / sampleRate;
+    previousStartMs = -1.0;
+
+    processor->setPlayConfigDetails(numDeviceChannels, numDeviceChannels, sampleRate, bufferSize);
+    processor->prepareToPlay(sampleRate, bufferSize);
+    processBuffer.setSize(juce::jmax(processor->getTotalNumInputChannels(), processor->getTotalNumOutputChannels()), bufferSize);
+    midi.ensureSize(256);
+
+    // Devices may call back a little more often than the nominal rate suggests
+    records.assign((size_t)(expectedCallbacks + expectedCallbacks / 10 + 16), {});
+    numRecords.store(0);
+
+    if (options.device == "file" && options.output != juce::File()) {
+        outputAudio.setSize(numDeviceChannels, expectedCallbacks * bufferSize);
+        outputAudio.clear();
+    }
+    inputPosition = 0;
+    outputPosition = 0;
+    return;
+}
+
+
+void LatencyRig::audioDeviceAboutToStart(juce::AudioIODevice* device) {
+    prepare(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
+    runStartMs.store(nowMs());
+    return;
+}
+
+
+void LatencyRig::audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                                  float* const* outputChannelData, int numOutputChannels,
+                                                  int numSamples, const juce::AudioIODeviceCallbackContext&) {
+    // A device callback is due one period after the previous one started
+    const auto startMs = nowMs();
+    const auto scheduledMs = previousStartMs < 0.0 ? startMs : previousStartMs + periodMs;
+    previousStartMs = startMs;
+    process(inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples, scheduledMs);
+    return;
+}
+
+
+void LatencyRig::process(const float* const* inputs, int numInputs, float* const* outputs, int numOutputs,
+                         int numSamples, double scheduledMs) {
+    const auto startMs = nowMs();
+    const auto numChannels = processBuffer.getNumChannels();
+    numSamples = juce::jmin(numSamples, processBuffer.getNumSamples());
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        if (ch < numInputs && inputs[ch] != nullptr)
+            processBuffer.copyFrom(ch, 0, inputs[ch], numSamples);
+        else
+            processBuffer.clear(ch, 0, numSamples);
+    }
+
+    // Refers to the preallocated channels, no allocation for a handful of them
+    juce::AudioBuffer<float> block(processBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+    midi.clear();
+    processor->processBlock(block, midi);
+
+    for (int ch = 0; ch < numOutputs; ch++) {
+        if (outputs[ch] == nullptr)
+            continue;
+        if (ch < numChannels)
+            juce::FloatVectorOperations::copy(outputs[ch], processBuffer.getReadPointer(ch), numSamples);
+        else
+            juce::FloatVectorOperations::clear(outputs[ch], numSamples);
+    }
+
+    const auto endMs = nowMs();
+    const auto index = numRecords.load(std::memory_order_relaxed);
+    if (index < (int)records.size()) {
+        auto& record = records[(size_t)index];
+        record.startMs = startMs - runStartMs.load();
+        record.jitterMs = startMs - scheduledMs;
+        record.processMs = endMs - startMs;
+        record.cpuPercent = (float)(100.0 * record.processMs / periodMs);
+        record.missedDeadline = endMs > scheduledMs + periodMs;
+        numRecords.store(index + 1, std::memory_order_release);
+    }
+    return;
+}
+
+
+void LatencyRig::timerCallback() {
+    if (pacedDevice != nullptr) {
+        if (isDone.load())
+            finish(pacedDevice->getXRuns());
+        return;
+    }
+
+    const auto elapsedSeconds = (nowMs() - runStartMs.load()) / 1000.0;
+    if (numRecords.load() > 0 && (elapsedSeconds >= options.seconds || numRecords.load() >= (int)records.size())) {
+        auto* device = deviceManager.getCurrentAudioDevice();
+        const auto xruns = device != nullptr ? device->getXRunCount() : -1;
+        deviceManager.removeAudioCallback(this);
+        finish(xruns);
+    }
+    return;
+}
+
+
+void LatencyRig::finish(int xruns) {
+    stopTimer();
+    if (pacedDevice != nullptr)
+        pacedDevice->stopThread(2000);
+    deviceManager.closeAudioDevice();
+    processor->releaseResources();
+    static_cast<SimpleEQAudioProcessor&>(*processor).getTraceRecorder().stop();
+
+    const auto count = numRecords.load(std::memory_order_acquire);
+    int misses = 0;
+    double jitterSum = 0.0, jitterMax = 0.0, cpuSum = 0.0;
+    std::vector<float> cpu;
+    cpu.reserve((size_t)count);
+    for (int i = 0; i < count; i++) {
+        const auto& record = records[(size_t)i];
+        misses += record.missedDeadline ? 1 : 0;
+        jitterSum += std::abs(record.jitterMs);
+        jitterMax = juce::jmax(jitterMax, std::abs(record.jitterMs));
+        cpuSum += record.cpuPercent;
+        cpu.push_back(record.cpuPercent);
+    }
+    std::sort(cpu.begin(), cpu.end());
+    auto percentile = [&cpu] (double p) { return cpu.empty() ? 0.0f : cpu[(size_t)((cpu.size() - 1) * p)]; };
+
+    juce::String summary;
+    summary << "device " << options.device << ", period " << juce::String(periodMs, 3) << " ms\n"
+            << "callbacks " << count << ", deadline misses " << misses
+            << ", xruns " << (xruns < 0 ? juce::String("n/a") : juce::String(xruns)) << "\n"
+            << "jitter mean " << juce::String(count > 0 ? jitterSum / count : 0.0, 3) << " ms, max " << juce::String(jitterMax, 3) << " ms\n"
+            << "cpu mean " << juce::String(count > 0 ? cpuSum / count : 0.0, 2) << " %, p99 " << juce::String(percentile(0.99), 2)
+            << " %, max " << juce::String(percentile(1.0), 2) << " %\n";
+    std::cout << summary;
+
+    if (options.log != juce::File()) {
+        juce::String csv;
+        csv << "callback,start_ms,jitter_ms,process_ms,cpu_percent,deadline_miss\n";
+        for (int i = 0; i < count; i++) {
+            const auto& record = records[(size_t)i];
+            csv << i << "," << record.startMs << "," << record.jitterMs << "," << record.processMs << ","
+                << record.cpuPercent << "," << (record.missedDeadline ? 1 : 0) << "\n";
+        }
+        options.log.replaceWithText(csv);
+    }
+
+    if (outputAudio.getNumSamples() > 0) {
+        options.output.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::OutputStream> stream(options.output.createOutputStream());
+        if (stream != nullptr) {
+            std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), processor->getSampleRate(), (unsigned int)numDeviceChannels, 24, {}, 0));
+            if (writer != nullptr) {
+                stream.release();
+                writer->writeFromAudioSampleBuffer(outputAudio, 0, outputPosition);
+            }
+        }
+    }
+
+    onFinished(misses > 0 || xruns > 0 ? 2 : 0);
+    return;
+}
+
+
+void LatencyRig::fail(const juce::String& message) {
+    std::cerr << message << std::endl;
+    onFinished(1);
+    return;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    LatencyRig.h
+    Headless host for the Standalone target, times every audio callback.
+
+    Runs SimpleEQAudioProcessor either on a real device (ALSA, JACK, ...)
+    or on a null/file device paced by a high priority thread, and logs
+    deadline misses, callback jitter and CPU use per callback.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+// Jake: Reproduces xruns without a DAW. Records are preallocated for the whole run and only
+// written out once the device has stopped, so the callback does no I/O and no allocation.
+class LatencyRig : private juce::AudioIODeviceCallback, private juce::Timer {
+public:
+    struct Options {
+        juce::String device = "null";   // "null", "file" or an AudioIODeviceType name
+        double sampleRate = 48000.0;
+        int bufferSize = 128;
+        double seconds = 10.0;
+        juce::File input;               // file device: looped as the input
+        juce::File output;              // file device: processed audio, optional
+        juce::File state;               // plugin state as written by getStateInformation, optional
+        juce::File log;                 // per callback CSV, optional
+        juce::File trace;               // processor trace, see TraceRecorder, optional
+
+        static Options fromArguments(const juce::ArgumentList& args);
+    };
+
+    // Jake: Times of one callback, in milliseconds from the start of the run
+    struct CallbackRecord {
+        double startMs = 0.0;
+        double jitterMs = 0.0;          // late start against the device period
+        double processMs = 0.0;
+        float cpuPercent = 0.0f;        // processing time over the period
+        bool missedDeadline = false;
+    };
+
+    explicit LatencyRig(const Options& options);
+    ~LatencyRig() override;
+
+    // Message thread. onFinished gets the exit code: 0, 1 on error, 2 when a deadline was missed.
+    void start(std::function<void(int)> onFinished);
+
+private:
+    class PacedDevice;
+
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                          float* const* outputChannelData, int numOutputChannels,
+                                          int numSamples, const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override {}
+    void timerCallback() override;
+
+    void prepare(double sampleRate, int bufferSize);
+    void process(const float* const* inputs, int numInputs, float* const* outputs, int numOutputs,
+                 int numSamples, double scheduledMs);
+    void finish(int xruns);
+    void fail(const juce::String& message);
+
+    Options options;
+    std::function<void(int)> onFinished;
+    std::unique_ptr<juce::AudioProcessor> processor;
+    juce::AudioDeviceManager deviceManager;
+    std::unique_ptr<PacedDevice> pacedDevice;
+
+    double periodMs = 0.0;
+    int expectedCallbacks = 0;
+    std::atomic<double> runStartMs {0.0};    // written on the message or device thread, read by the paced device
+    double previousStartMs = -1.0;
+    juce::AudioBuffer<float> processBuffer;
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> inputAudio;    // file device
+    juce::AudioBuffer<float> outputAudio;
+    int inputPosition = 0;
+    int outputPosition = 0;
+
+    std::vector<CallbackRecord> records;
+    std::atomic<int> numRecords {0};
+    std::atomic<bool> isDone {false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyRig)
+};
@@ -0,0 +1,423 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+    Peak, RMS, true-peak and EBU R128 loudness metering tap.
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+namespace {
+    constexpr float silenceLoudness = -100.0f;
+
+    // Single writer, the reader swaps in zero when it collects the value
+    void storeMax(std::atomic<float>& target, float value) {
+        auto current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    float getAbsoluteMax(const float* data, int numSamples) {
+        auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    // Steps smaller than a tenth of the readouts' 0.1 dB aren't worth a repaint
+    bool hasMovedGain(float a, float b) {
+        return std::abs(a - b) > 0.0012f * juce::jmax(std::abs(a), std::abs(b));
+    }
+
+    bool hasMovedDecibels(float a, float b) {
+        return std::abs(a - b) > 0.01f;
+    }
+
+    float meanSquareToLoudness(double meanSquare) {
+        if (meanSquare <= 1.0e-10)
+            return silenceLoudness;
+        return (float)(-0.691 + 10.0 * std::log10(meanSquare));
+    }
+}
+
+//==============================================================================
+float getSumOfSquares(const float* data, int numSamples) {
+    float sum = 0.0f;
+    int i = 0;
+
+   #if JUCE_USE_SIMD
+    using SIMD = juce::dsp::SIMDRegister<float>;
+    constexpr auto width = (int)SIMD::SIMDNumElements;
+
+    // Scalar until the data is aligned, then whole registers, then the remainder
+    for (; i < numSamples && !SIMD::isSIMDAligned(data + i); i++) {
+        sum += data[i] * data[i];
+    }
+
+    auto accumulator = SIMD::expand(0.0f);
+    for (; i + width <= numSamples; i += width) {
+        auto x = SIMD::fromRawArray(data + i);
+        accumulator = SIMD::multiplyAdd(accumulator, x, x);
+    }
+    sum += accumulator.sum();
+   #endif
+
+    for (; i < numSamples; i++) {
+        sum += data[i] * data[i];
+    }
+    return sum;
+}
+
+
+//==============================================================================
+void LevelMeter::prepare(double sampleRate, int maximumBlockSize, int numChannels) {
+    numMeteredChannels = juce::jmin(numChannels, maxChannels);
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    samplesPerBin = juce::jmax(1, juce::roundToInt(sampleRate / binsPerSecond));
+    kWeighting = makeKWeightingFilter(sampleRate);
+
+    // The loop in getKWeightedSumOfSquares() leaves the high pass numerator out
+    jassert(kWeighting[1].b0 == 1.0f && kWeighting[1].b1 == -2.0f && kWeighting[1].b2 == 1.0f);
+
+    // Windowed sinc interpolator, phase p estimates the signal p / oversamplingFactor samples
+    // after the centre of the taps. Phase 0 is the input itself and covered by the sample peak.
+    const double centre = tapsPerPhase / 2;
+    interpolationGain = 1.0f;
+    for (int p = 1; p < oversamplingFactor; p++) {
+        auto& taps = interpolationTaps[(size_t)p - 1];
+        double sum = 0.0;
+        for (int k = 0; k < tapsPerPhase; k++) {
+            const double u = centre - k - (double)p / oversamplingFactor;
+            const double sinc = std::sin(juce::MathConstants<double>::pi * u) / (juce::MathConstants<double>::pi * u);
+            const double window = 0.5 * (1.0 + std::cos(juce::MathConstants<double>::pi * u / centre));
+            taps[(size_t)k] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+        // Unity gain at DC
+        auto absoluteSum = 0.0f;
+        for (auto& tap : taps) {
+            tap = (float)(tap / sum);
+            absoluteSum += std::abs(tap);
+        }
+        interpolationGain = juce::jmax(interpolationGain, absoluteSum);
+    }
+
+    for (auto& state : channels) {
+        state.history.resize((size_t)(tapsPerPhase - 1 + maxBlockSize));
+    }
+    interpolated.resize((size_t)maxBlockSize);
+   #if JUCE_USE_SIMD
+    stereoFrames.resize((size_t)maxBlockSize, juce::dsp::SIMDRegister<float>::expand(0.0f));
+   #endif
+
+    // The audio thread resets the measurement on its next enabled block
+    isRunning = false;
+    isPrepared = true;
+    return;
+}
+
+
+void LevelMeter::release() {
+    isPrepared = false;
+    isRunning = false;
+    for (auto& state : channels) {
+        state.history.clear();
+        state.history.shrink_to_fit();
+    }
+    interpolated.clear();
+    interpolated.shrink_to_fit();
+   #if JUCE_USE_SIMD
+    stereoFrames.clear();
+    stereoFrames.shrink_to_fit();
+   #endif
+    return;
+}
+
+
+void LevelMeter::reset() {
+    for (auto& state : channels) {
+        state.stage1 = {};
+        state.stage2 = {};
+        std::fill(state.history.begin(), state.history.end(), 0.0f);
+        state.truePeakHold = 0.0f;
+        state.weightedSum = 0.0;
+        state.rawSum = 0.0;
+        state.rawBins = {};
+    }
+    loudnessBins = {};
+    samplesInBin = 0;
+    nextBin = 0;
+    numFilledBins = 0;
+    rmsBinIndex = 0;
+
+    for (int ch = 0; ch < maxChannels; ch++) {
+        peak[ch].store(0.0f);
+        truePeak[ch].store(0.0f);
+        rms[ch].store(0.0f);
+    }
+    momentaryLoudness.store(silenceLoudness);
+    shortTermLoudness.store(silenceLoudness);
+    binPeak = {};
+    lastBinPeak = {};
+    lastRms = {};
+    lastMomentaryLoudness = silenceLoudness;
+    lastShortTermLoudness = silenceLoudness;
+    return;
+}
+
+
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer) {
+    if (!isPrepared || !enabled.load(std::memory_order_relaxed)) {
+        isRunning = false;
+        return;
+    }
+
+    if (!isRunning) {
+        reset();
+        isRunning = true;
+    }
+    if (truePeakHoldResetRequested.exchange(false, std::memory_order_relaxed)) {
+        for (auto& state : channels) {
+            state.truePeakHold = 0.0f;
+        }
+    }
+
+    // Hosts may exceed the block size they announced, meter in prepared sized chunks
+    const auto numSamples = buffer.getNumSamples();
+    for (int start = 0; start < numSamples; start += maxBlockSize) {
+        processChunk(buffer, start, juce::jmin(maxBlockSize, numSamples - start));
+    }
+    return;
+}
+
+
+void LevelMeter::processChunk(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+    const auto numChannels = juce::jmin(numMeteredChannels, buffer.getNumChannels());
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        auto& state = channels[(size_t)ch];
+        const auto* data = buffer.getReadPointer(ch, startSample);
+
+        const auto blockPeak = getAbsoluteMax(data, numSamples);
+        binPeak[(size_t)ch] = juce::jmax(binPeak[(size_t)ch], blockPeak);
+        storeMax(peak[(size_t)ch], blockPeak);
+        storeMax(truePeak[(size_t)ch], getTruePeak(state, data, numSamples, blockPeak));
+    }
+
+    // Accumulate energy into 100 ms bins, the chunk may complete several of them. The K-weighting
+    // runs bin by bin so its output goes straight into the sum.
+    int offset = 0;
+    while (offset < numSamples) {
+        const auto length = juce::jmin(numSamples - offset, samplesPerBin - samplesInBin);
+        addKWeightedSumsOfSquares(buffer, startSample + offset, length, numChannels);
+        for (int ch = 0; ch < numChannels; ch++) {
+            channels[(size_t)ch].rawSum += getSumOfSquares(buffer.getReadPointer(ch, startSample + offset), length);
+        }
+
+        offset += length;
+        samplesInBin += length;
+        if (samplesInBin == samplesPerBin)
+            finishBin();
+    }
+    return;
+}
+
+
+float LevelMeter::getTruePeak(ChannelState& state, const float* data, int numSamples, float blockPeak) {
+    // History holds the last tapsPerPhase - 1 inputs followed by this chunk
+    auto* history = state.history.data();
+    constexpr int historyLength = tapsPerPhase - 1;
+    std::copy(data, data + numSamples, history + historyLength);
+
+    // No interpolated value can exceed the largest input under the taps times their absolute
+    // sum. A chunk that can't raise the hold has nothing a display would show, keep its history.
+    const auto inputPeak = juce::jmax(blockPeak, getAbsoluteMax(history, historyLength));
+    if (inputPeak * interpolationGain <= state.truePeakHold) {
+        std::copy(history + numSamples, history + numSamples + historyLength, history);
+        return blockPeak;
+    }
+
+    // Each phase is a short FIR over the whole chunk. The taps are unrolled inside the sample
+    // loop, which the compiler vectorises across samples, so every output is written once.
+    float maxValue = blockPeak;
+    for (const auto& taps : interpolationTaps) {
+        auto* output = interpolated.data();
+        for (int i = 0; i < numSamples; i++) {
+            auto sum = 0.0f;
+            for (int k = 0; k < tapsPerPhase; k++) {
+                sum += taps[(size_t)k] * history[historyLength + i - k];
+            }
+            output[i] = sum;
+        }
+        maxValue = juce::jmax(maxValue, getAbsoluteMax(interpolated.data(), numSamples));
+    }
+
+    std::copy(history + numSamples, history + numSamples + historyLength, history);
+    state.truePeakHold = juce::jmax(state.truePeakHold, maxValue);
+    return maxValue;
+}
+
+
+float LevelMeter::getKWeightedSumOfSquares(ChannelState& state, const float* data, int numSamples) const {
+    const auto& shelf = kWeighting[0];
+    const auto& highPass = kWeighting[1];
+    auto s1 = state.stage1;
+    auto s2 = state.stage2;
+
+    // Transposed direct form II in float. The coefficients are floats anyway, and the sum only
+    // has to hold a bin, which the caller accumulates in double. The high pass numerator is 1, -2, 1.
+    auto sum = 0.0f;
+    for (int i = 0; i < numSamples; i++) {
+        const auto x = data[i];
+        const auto y1 = shelf.b0 * x + s1[0];
+        s1[0] = shelf.b1 * x - shelf.a1 * y1 + s1[1];
+        s1[1] = shelf.b2 * x - shelf.a2 * y1;
+
+        const auto y2 = y1 + s2[0];
+        s2[0] = s2[1] - 2.0f * y1 - highPass.a1 * y2;
+        s2[1] = y1 - highPass.a2 * y2;
+        sum += y2 * y2;
+    }
+
+    state.stage1 = s1;
+    state.stage2 = s2;
+    return sum;
+}
+
+
+void LevelMeter::addKWeightedSumsOfSquares(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels) {
+   #if JUCE_USE_SIMD
+    // Each sample waits for the previous one through the feedback, so a channel alone leaves
+    // the FPU idle most of the time. Stereo runs both channels in the lanes of one register,
+    // the same loop as getKWeightedSumOfSquares() at the latency of one channel. The frames are
+    // gathered in a pass of their own, loading a register right after writing its lanes stalls.
+    if (numChannels == 2) {
+        using SIMD = juce::dsp::SIMDRegister<float>;
+        const auto& shelf = kWeighting[0];
+        const auto& highPass = kWeighting[1];
+        auto& left = channels[0];
+        auto& right = channels[1];
+        const auto* leftData = buffer.getReadPointer(0, startSample);
+        const auto* rightData = buffer.getReadPointer(1, startSample);
+        constexpr auto width = (int)SIMD::SIMDNumElements;
+        auto* frames = reinterpret_cast<float*>(stereoFrames.data());
+        for (int i = 0; i < numSamples; i++) {
+            frames[i * width] = leftData[i];
+            frames[i * width + 1] = rightData[i];
+        }
+
+        const auto pack = [] (float l, float r) {
+            auto lanes = SIMD::expand(0.0f);
+            lanes.set(0, l);
+            lanes.set(1, r);
+            return lanes;
+        };
+        auto s10 = pack(left.stage1[0], right.stage1[0]), s11 = pack(left.stage1[1], right.stage1[1]);
+        auto s20 = pack(left.stage2[0], right.stage2[0]), s21 = pack(left.stage2[1], right.stage2[1]);
+        auto sum = SIMD::expand(0.0f);
+        for (int i = 0; i < numSamples; i++) {
+            const auto x = SIMD::fromRawArray(frames + i * width);
+            const auto y1 = x * shelf.b0 + s10;
+            s10 = x * shelf.b1 - y1 * shelf.a1 + s11;
+            s11 = x * shelf.b2 - y1 * shelf.a2;
+
+            const auto y2 = y1 + s20;
+            s20 = s21 - y1 * 2.0f - y2 * highPass.a1;
+            s21 = y1 - y2 * highPass.a2;
+            sum += y2 * y2;
+        }
+
+        left.stage1 = {s10.get(0), s11.get(0)};
+        right.stage1 = {s10.get(1), s11.get(1)};
+        left.stage2 = {s20.get(0), s21.get(0)};
+        right.stage2 = {s20.get(1), s21.get(1)};
+        left.weightedSum += sum.get(0);
+        right.weightedSum += sum.get(1);
+        return;
+    }
+   #endif
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        auto& state = channels[(size_t)ch];
+        state.weightedSum += getKWeightedSumOfSquares(state, buffer.getReadPointer(ch, startSample), numSamples);
+    }
+    return;
+}
+
+
+void LevelMeter::finishBin() {
+    // Channel weights are 1 for mono and stereo, so the bin is the plain sum of mean squares
+    double meanSquare = 0.0;
+    auto hasMoved = false;
+    for (int ch = 0; ch < numMeteredChannels; ch++) {
+        auto& state = channels[(size_t)ch];
+        meanSquare += state.weightedSum / samplesPerBin;
+        state.rawBins[(size_t)rmsBinIndex] = state.rawSum / samplesPerBin;
+        state.weightedSum = 0.0;
+        state.rawSum = 0.0;
+
+        double rawMean = 0.0;
+        for (auto bin : state.rawBins) {
+            rawMean += bin;
+        }
+        const auto channelRms = (float)std::sqrt(rawMean / rmsBins);
+        rms[(size_t)ch].store(channelRms, std::memory_order_relaxed);
+
+        hasMoved = hasMoved || hasMovedGain(channelRms, lastRms[(size_t)ch]) || hasMovedGain(binPeak[(size_t)ch], lastBinPeak[(size_t)ch]);
+        lastRms[(size_t)ch] = channelRms;
+        lastBinPeak[(size_t)ch] = binPeak[(size_t)ch];
+        binPeak[(size_t)ch] = 0.0f;
+    }
+    rmsBinIndex = (rmsBinIndex + 1) % rmsBins;
+
+    loudnessBins[(size_t)nextBin] = meanSquare;
+    nextBin = (nextBin + 1) % shortTermBins;
+    numFilledBins = juce::jmin(numFilledBins + 1, shortTermBins);
+    samplesInBin = 0;
+
+    // Windows that haven't filled up yet average over what has been measured so far
+    double momentarySum = 0.0;
+    const auto numMomentary = juce::jmin(numFilledBins, momentaryBins);
+    for (int i = 1; i <= numMomentary; i++) {
+        momentarySum += loudnessBins[(size_t)((nextBin - i + shortTermBins) % shortTermBins)];
+    }
+    double shortTermSum = 0.0;
+    for (int i = 0; i < numFilledBins; i++) {
+        shortTermSum += loudnessBins[(size_t)((nextBin - 1 - i + shortTermBins) % shortTermBins)];
+    }
+
+    const auto momentary = meanSquareToLoudness(momentarySum / numMomentary);
+    const auto shortTerm = meanSquareToLoudness(shortTermSum / numFilledBins);
+    momentaryLoudness.store(momentary, std::memory_order_relaxed);
+    shortTermLoudness.store(shortTerm, std::memory_order_relaxed);
+
+    hasMoved = hasMoved || hasMovedDecibels(momentary, lastMomentaryLoudness) || hasMovedDecibels(shortTerm, lastShortTermLoudness);
+    lastMomentaryLoudness = momentary;
+    lastShortTermLoudness = shortTerm;
+    if (hasMoved) {
+        // Count before looking at the request, a display arming it afterwards sees the new count
+        changeCount.store(changeCount.load(std::memory_order_relaxed) + 1);
+        if (wakeOnChange.exchange(false))
+            triggerAsyncUpdate();
+    }
+    return;
+}
+
+
+void LevelMeter::handleAsyncUpdate() {
+    if (onChange != nullptr)
+        onChange();
+    return;
+}
+
+
+LevelMeter::Readings LevelMeter::getReadings() {
+    Readings readings;
+    for (size_t ch = 0; ch < (size_t)maxChannels; ch++) {
+        readings.peak[ch] = peak[ch].exchange(0.0f, std::memory_order_relaxed);
+        readings.truePeak[ch] = truePeak[ch].exchange(0.0f, std::memory_order_relaxed);
+        readings.rms[ch] = rms[ch].load(std::memory_order_relaxed);
+    }
+    readings.momentaryLoudness = momentaryLoudness.load(std::memory_order_relaxed);
+    readings.shortTermLoudness = shortTermLoudness.load(std::memory_order_relaxed);
+    return readings;
+}
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+    Peak, RMS, true-peak and EBU R128 loudness metering tap.
+
+    Runs on the audio thread inside processBlock, readings are published
+    through atomics and picked up by the editor on its refresh tick.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "EQDesign.h"
+
+
+// Jake: Sum of x^2 over the block, vectorised with juce::dsp::SIMDRegister where available
+float getSumOfSquares(const float* data, int numSamples);
+
+
+// Jake: Measures one bus. Everything is allocated in prepare(), process() only touches
+// preallocated buffers, and the meter does no work at all while it isn't enabled.
+class LevelMeter : private juce::AsyncUpdater {
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int oversamplingFactor = 4;
+    static constexpr int tapsPerPhase = 8;
+
+    // Linear peak/RMS per channel, loudness in LUFS
+    struct Readings {
+        std::array<float, maxChannels> peak {};
+        std::array<float, maxChannels> truePeak {};
+        std::array<float, maxChannels> rms {};
+        float momentaryLoudness = -100.0f;
+        float shortTermLoudness = -100.0f;
+    };
+
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void release();
+
+    // Any thread. The editor enables the meters while it is open, state restarts on enable.
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled); }
+    bool isEnabled() const { return enabled.load(); }
+
+    // Audio thread
+    void process(const juce::AudioBuffer<float>& buffer);
+
+    // Message thread: peaks since the previous call, RMS over 300 ms and loudness over
+    // the momentary (400 ms) and short-term (3 s) windows
+    Readings getReadings();
+
+    // Any thread. Displays only show the highest true peak since they were last cleared, so the
+    // meter skips interpolating blocks that can't raise it. Call this when the display clears it.
+    void resetTruePeakHold() { truePeakHoldResetRequested.store(true); }
+
+    // Any thread. Bumped by every 100 ms bin that moved a reading by more than a display shows.
+    juce::uint32 getChangeCount() const { return changeCount.load(); }
+
+    // Message thread. After requestWakeOnChange(), onChange is called once on the message thread
+    // when the next change is counted, so a display can stop refreshing while nothing moves.
+    std::function<void()> onChange;
+    void requestWakeOnChange() { wakeOnChange.store(true); }
+
+private:
+    static constexpr int binsPerSecond = 10;
+    static constexpr int momentaryBins = 4;
+    static constexpr int shortTermBins = 30;
+    static constexpr int rmsBins = 3;
+
+    struct ChannelState {
+        std::array<float, 2> stage1 {}, stage2 {};      // K-weighting filter state
+        std::vector<float> history;                     // true-peak interpolator input
+        float truePeakHold = 0.0f;                      // highest true peak since the display cleared it
+        double weightedSum = 0.0;                       // current bin
+        double rawSum = 0.0;
+        std::array<double, rmsBins> rawBins {};
+    };
+
+    void reset();
+    void processChunk(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    float getTruePeak(ChannelState& state, const float* data, int numSamples, float blockPeak);
+    float getKWeightedSumOfSquares(ChannelState& state, const float* data, int numSamples) const;
+    void addKWeightedSumsOfSquares(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels);
+    void finishBin();
+    void handleAsyncUpdate() override;
+
+    std::atomic<bool> enabled {false};
+    bool isRunning = false;
+    bool isPrepared = false;
+    int numMeteredChannels = 0;
+    int maxBlockSize = 0;
+    int samplesPerBin = 0;
+    int samplesInBin = 0;
+
+    std::array<BiquadCoefficients, 2> kWeighting;
+    std::array<std::array<float, tapsPerPhase>, oversamplingFactor - 1> interpolationTaps {};
+    float interpolationGain = 1.0f;     // largest sum of absolute taps of any phase
+    std::array<ChannelState, maxChannels> channels;
+    std::vector<float> interpolated;    // one interpolator phase of the chunk
+   #if JUCE_USE_SIMD
+    std::vector<juce::dsp::SIMDRegister<float>> stereoFrames;  // both channels of a bin segment, a register per frame
+   #endif
+    std::atomic<bool> truePeakHoldResetRequested {false};
+
+    std::array<double, shortTermBins> loudnessBins {};
+    int nextBin = 0;
+    int numFilledBins = 0;
+    int rmsBinIndex = 0;
+
+    // Published to the message thread
+    std::array<std::atomic<float>, maxChannels> peak {};
+    std::array<std::atomic<float>, maxChannels> truePeak {};
+    std::array<std::atomic<float>, maxChannels> rms {};
+    std::atomic<float> momentaryLoudness {-100.0f};
+    std::atomic<float> shortTermLoudness {-100.0f};
+
+    // What the previous bin published, to tell whether this one moved anything
+    std::array<float, maxChannels> binPeak {};
+    std::array<float, maxChannels> lastBinPeak {};
+    std::array<float, maxChannels> lastRms {};
+    float lastMomentaryLoudness = -100.0f;
+    float lastShortTermLoudness = -100.0f;
+    std::atomic<juce::uint32> changeCount {0};
+    std::atomic<bool> wakeOnChange {false};
+};
@@ -0,0 +1,608 @@
+/*
+  ==============================================================================
+
+    MatchEQ.cpp
+    Derives ChainSettings that move the input's tonal balance towards a reference.
+
+  ==============================================================================
+*/
+
+#include "MatchEQ.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Points further below the loudest point of either spectrum are noise floor, not tone
+    constexpr double floorDecibels = 60.0;
+    constexpr double maxTargetDecibels = 30.0;
+
+    // Reference files are analysed up to this length, a long average doesn't need more
+    constexpr double maxFileSeconds = 600.0;
+    constexpr int fileBlockSize = 1 << 16;
+
+    // Frequencies and quality are fitted in octaves, so a step means the same across the range
+    enum FitParameter {
+        Fit_LowCut,
+        Fit_HighCut,
+        Fit_PeakFreq,
+        Fit_PeakGain,
+        Fit_PeakQuality,
+        NumFitParameters
+    };
+    using FitParameters = std::array<double, NumFitParameters>;
+
+    constexpr FitParameters lowerBounds {4.321928, 4.321928, 4.321928, -24.0, -3.321928};    // log2 20 Hz, log2 0.1
+    constexpr FitParameters upperBounds {14.287712, 14.287712, 14.287712, 24.0, 3.321928};   // log2 20 kHz, log2 10
+    constexpr FitParameters derivativeSteps {0.01, 0.01, 0.01, 0.05, 0.01};
+    constexpr int maxIterations = 50;
+
+    FitParameters toFitParameters(const ChainSettings& settings) {
+        FitParameters p;
+        p[Fit_LowCut] = std::log2(juce::jmax(1.0f, settings.lowCutFreq));
+        p[Fit_HighCut] = std::log2(juce::jmax(1.0f, settings.highCutFreq));
+        p[Fit_PeakFreq] = std::log2(juce::jmax(1.0f, settings.peakFreq));
+        p[Fit_PeakGain] = settings.peakGainInDecibels;
+        p[Fit_PeakQuality] = std::log2(juce::jmax(0.01f, settings.peakQuality));
+        return p;
+    }
+
+    ChainSettings toChainSettings(const FitParameters& p, ChainSettings settings) {
+        settings.lowCutFreq = (float)std::exp2(p[Fit_LowCut]);
+        settings.highCutFreq = (float)std::exp2(p[Fit_HighCut]);
+        settings.peakFreq = (float)std::exp2(p[Fit_PeakFreq]);
+        settings.peakGainInDecibels = (float)p[Fit_PeakGain];
+        settings.peakQuality = (float)std::exp2(p[Fit_PeakQuality]);
+        return settings;
+    }
+
+    FitParameters clampToBounds(FitParameters p) {
+        for (size_t k = 0; k < p.size(); k++) {
+            p[k] = juce::jlimit(lowerBounds[k], upperBounds[k], p[k]);
+        }
+        return p;
+    }
+
+    // Solves a x = b in place by Gaussian elimination with partial pivoting, false if singular
+    bool solve(std::array<FitParameters, NumFitParameters>& a, FitParameters& b) {
+        constexpr auto n = (size_t)NumFitParameters;
+        for (size_t col = 0; col < n; col++) {
+            auto pivot = col;
+            for (auto row = col + 1; row < n; row++) {
+                if (std::abs(a[row][col]) > std::abs(a[pivot][col]))
+                    pivot = row;
+            }
+            if (std::abs(a[pivot][col]) < 1.0e-300)
+                return false;
+            std::swap(a[col], a[pivot]);
+            std::swap(b[col], b[pivot]);
+
+            for (auto row = col + 1; row < n; row++) {
+                const auto factor = a[row][col] / a[col][col];
+                for (auto k = col; k < n; k++) {
+                    a[row][k] -= factor * a[col][k];
+                }
+                b[row] -= factor * b[col];
+            }
+        }
+        for (auto col = n; col-- > 0;) {
+            for (auto k = col + 1; k < n; k++) {
+                b[col] -= a[col][k] * b[k];
+            }
+            b[col] /= a[col][col];
+        }
+        return true;
+    }
+
+    // Jake: Evaluates candidate designs against the target. The scratch lives here, so the
+    // search doesn't allocate per evaluation.
+    struct FitProblem {
+        FitProblem(const MatchTarget& matchTarget, const ChainSettings& baseSettings, double rate)
+            : target(matchTarget), base(baseSettings), sampleRate(rate) {
+            evaluator.prepare(target.frequencies, sampleRate);
+            response.resize(target.frequencies.size());
+            for (auto weight : target.weights) {
+                totalWeight += weight;
+            }
+        }
+
+        // Weighted residuals with the best level offset taken out, returns their sum of squares
+        double getResiduals(const FitParameters& p, std::vector<double>& residuals) {
+            evaluator.getDecibels(makeChainCoefficients(toChainSettings(p, base), sampleRate), response.data());
+
+            double offset = 0.0;
+            for (size_t i = 0; i < response.size(); i++) {
+                offset += target.weights[i] * (response[i] - target.decibels[i]);
+            }
+            offset /= totalWeight;
+
+            residuals.resize(response.size());
+            double cost = 0.0;
+            for (size_t i = 0; i < response.size(); i++) {
+                residuals[i] = std::sqrt(target.weights[i]) * (response[i] - target.decibels[i] - offset);
+                cost += residuals[i] * residuals[i];
+            }
+            return cost;
+        }
+
+        const MatchTarget& target;
+        ChainSettings base;
+        double sampleRate;
+        MagnitudeEvaluator evaluator;
+        std::vector<double> response;
+        double totalWeight = 0.0;
+    };
+
+    // Levenberg-Marquardt on forward difference derivatives, steps that leave the parameter
+    // ranges are clamped back onto them. Returns the cost reached, p holds the solution.
+    double fitFrom(FitProblem& problem, FitParameters& p) {
+        std::vector<double> residuals, trialResiduals;
+        std::array<std::vector<double>, NumFitParameters> jacobian;
+        auto cost = problem.getResiduals(p, residuals);
+        auto lambda = 1.0e-2;
+
+        for (int iteration = 0; iteration < maxIterations; iteration++) {
+            for (size_t k = 0; k < jacobian.size(); k++) {
+                auto shifted = p;
+                auto step = derivativeSteps[k];
+                if (shifted[k] + step > upperBounds[k])
+                    step = -step;
+                shifted[k] += step;
+                problem.getResiduals(shifted, jacobian[k]);
+                for (size_t i = 0; i < residuals.size(); i++) {
+                    jacobian[k][i] = (jacobian[k][i] - residuals[i]) / step;
+                }
+            }
+
+            std::array<FitParameters, NumFitParameters> normal {};
+            FitParameters gradient {};
+            for (size_t j = 0; j < jacobian.size(); j++) {
+                for (size_t k = 0; k < jacobian.size(); k++) {
+                    for (size_t i = 0; i < residuals.size(); i++) {
+                        normal[j][k] += jacobian[j][i] * jacobian[k][i];
+                    }
+                }
+                for (size_t i = 0; i < residuals.size(); i++) {
+                    gradient[j] -= jacobian[j][i] * residuals[i];
+                }
+            }
+
+            // Raise the damping until a step improves, or give up when none does
+            auto improved = false;
+            auto previousCost = cost;
+            while (lambda < 1.0e7) {
+                auto damped = normal;
+                auto step = gradient;
+                for (size_t k = 0; k < step.size(); k++) {
+                    damped[k][k] += lambda * (normal[k][k] + 1.0e-6);
+                }
+
+                if (solve(damped, step)) {
+                    FitParameters trial;
+                    for (size_t k = 0; k < trial.size(); k++) {
+                        trial[k] = p[k] + step[k];
+                    }
+                    trial = clampToBounds(trial);
+                    const auto trialCost = problem.getResiduals(trial, trialResiduals);
+                    if (trialCost < cost) {
+                        p = trial;
+                        cost = trialCost;
+                        std::swap(residuals, trialResiduals);
+                        lambda = juce::jmax(lambda * 0.3, 1.0e-7);
+                        improved = true;
+                        break;
+                    }
+                }
+                lambda *= 10.0;
+            }
+
+            if (!improved || previousCost - cost < 1.0e-6 * previousCost)
+                break;
+        }
+        return cost;
+    }
+}
+
+//==============================================================================
+void AveragedSpectrum::reset(double newSampleRate) {
+    sampleRate = newSampleRate;
+    framePosition = 0;
+    numFrames = 0;
+    std::fill(powerSum.begin(), powerSum.end(), 0.0);
+    return;
+}
+
+
+void AveragedSpectrum::process(const float* samples, int numSamples) {
+    if (fft == nullptr) {
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    }
+    // swapAccumulated() can hand over the empty buffers of a spectrum that never processed
+    // anything, these only allocate then
+    frame.resize((size_t)fftSize);
+    workspace.resize((size_t)(2 * fftSize));
+    powerSum.resize((size_t)numBins);
+    
+    while (numSamples > 0) {
+        const auto count = juce::jmin(numSamples, fftSize - framePosition);
+        std::copy(samples, samples + count, frame.begin() + framePosition);
+        framePosition += count;
+        samples += count;
+        numSamples -= count;
+
+        if (framePosition == fftSize) {
+            addFrame();
+            // The second half starts the next frame
+            std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+            framePosition = fftSize - hopSize;
+        }
+    }
+    return;
+}
+
+
+void AveragedSpectrum::addFrame() {
+    std::copy(frame.begin(), frame.end(), workspace.begin());
+    std::fill(workspace.begin() + fftSize, workspace.end(), 0.0f);
+    window->multiplyWithWindowingTable(workspace.data(), (size_t)fftSize);
+    fft->performFrequencyOnlyForwardTransform(workspace.data(), true);
+
+    for (size_t k = 0; k < powerSum.size(); k++) {
+        powerSum[k] += (double)workspace[k] * (double)workspace[k];
+    }
+    numFrames++;
+    return;
+}
+
+
+double AveragedSpectrum::getSeconds() const {
+    if (numFrames == 0 || sampleRate <= 0.0)
+        return 0.0;
+    return (fftSize + (numFrames - 1) * hopSize) / sampleRate;
+}
+
+
+void AveragedSpectrum::swapAccumulated(AveragedSpectrum& other) {
+    std::swap(frame, other.frame);
+    std::swap(powerSum, other.powerSum);
+    std::swap(framePosition, other.framePosition);
+    std::swap(numFrames, other.numFrames);
+    std::swap(sampleRate, other.sampleRate);
+    return;
+}
+
+
+std::vector<double> AveragedSpectrum::getDecibels(const std::vector<double>& frequencies, double octaveFraction) const {
+    std::vector<double> decibels(frequencies.size(), -200.0);
+    if (numFrames == 0 || sampleRate <= 0.0)
+        return decibels;
+
+    const auto binsPerHertz = fftSize / sampleRate;
+    const auto halfWidth = std::exp2(0.5 * octaveFraction);
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        const auto frequency = frequencies[i];
+        if (frequency <= 0.0 || frequency >= 0.5 * sampleRate)
+            continue;
+
+        // Every bin inside the band, or the nearest one where the band is narrower than a bin
+        auto first = (int)std::ceil(frequency / halfWidth * binsPerHertz);
+        auto last = (int)std::floor(frequency * halfWidth * binsPerHertz);
+        if (last < first)
+            first = last = juce::roundToInt(frequency * binsPerHertz);
+        first = juce::jlimit(1, numBins - 1, first);
+        last = juce::jlimit(first, numBins - 1, last);
+
+        double power = 0.0;
+        for (auto bin = first; bin <= last; bin++) {
+            power += powerSum[(size_t)bin];
+        }
+        power /= (double)(last - first + 1) * numFrames;
+        decibels[i] = 10.0 * std::log10(juce::jmax(power, 1.0e-20));
+    }
+    return decibels;
+}
+
+
+//==============================================================================
+bool analyseAudioFile(const juce::File& file, AveragedSpectrum& spectrum, juce::Thread* thread) {
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+    
+    const auto readable = reader != nullptr && reader->sampleRate > 0.0 && reader->numChannels > 0;
+    spectrum.reset(readable ? reader->sampleRate : 0.0);
+    if (!readable)
+        return false;
+    
+    const auto numChannels = juce::jmin((int)reader->numChannels, 2);
+    const auto gain = 1.0f / (float)numChannels;
+    const auto length = juce::jmin(reader->lengthInSamples, (juce::int64)(maxFileSeconds * reader->sampleRate));
+    juce::AudioBuffer<float> block(numChannels, fileBlockSize);
+    std::vector<float> mix((size_t)fileBlockSize);
+    
+    for (juce::int64 position = 0; position < length; position += fileBlockSize) {
+        if (thread != nullptr && thread->threadShouldExit())
+            break;
+        
+        const auto count = (int)juce::jmin((juce::int64)fileBlockSize, length - position);
+        reader->read(&block, 0, count, position, true, numChannels > 1);
+        juce::FloatVectorOperations::copyWithMultiply(mix.data(), block.getReadPointer(0), gain, count);
+        for (int ch = 1; ch < numChannels; ch++) {
+            juce::FloatVectorOperations::addWithMultiply(mix.data(), block.getReadPointer(ch), gain, count);
+        }
+        spectrum.process(mix.data(), count);
+    }
+    return true;
+}
+
+
+MatchTarget makeMatchTarget(const AveragedSpectrum& input, const AveragedSpectrum& reference, int numPoints) {
+    // Stay clear of Nyquist of either signal
+    const auto maxFrequency = juce::jmin(20000.0, 0.45 * input.getSampleRate(), 0.45 * reference.getSampleRate());
+
+    MatchTarget target;
+    target.frequencies = makeLogFrequencyGrid(numPoints, 20.0, juce::jmax(40.0, maxFrequency));
+    const auto inputDecibels = input.getDecibels(target.frequencies);
+    const auto referenceDecibels = reference.getDecibels(target.frequencies);
+    const auto inputFloor = *std::max_element(inputDecibels.begin(), inputDecibels.end()) - floorDecibels;
+    const auto referenceFloor = *std::max_element(referenceDecibels.begin(), referenceDecibels.end()) - floorDecibels;
+
+    target.decibels.resize(target.frequencies.size());
+    target.weights.resize(target.frequencies.size());
+    for (size_t i = 0; i < target.frequencies.size(); i++) {
+        const auto trusted = inputDecibels[i] > inputFloor && referenceDecibels[i] > referenceFloor;
+        target.decibels[i] = juce::jlimit(-maxTargetDecibels, maxTargetDecibels, referenceDecibels[i] - inputDecibels[i]);
+        target.weights[i] = trusted ? 1.0 : 0.0;
+    }
+    return target;
+}
+
+
+MatchFit fitChainSettings(const MatchTarget& target, const ChainSettings& current, double sampleRate) {
+    MatchFit fit;
+    fit.settings = current;
+
+    FitProblem problem(target, current, sampleRate);
+    if (problem.totalWeight <= 0.0 || target.frequencies.empty())
+        return fit;
+
+    // The level offset is free, so the peak starts from the target's deviation from its mean
+    double meanTarget = 0.0;
+    for (size_t i = 0; i < target.decibels.size(); i++) {
+        meanTarget += target.weights[i] * target.decibels[i];
+    }
+    meanTarget /= problem.totalWeight;
+
+    // The current settings and a peak at each of a few spots with both cuts open. The cost has
+    // local minima, one peak can only settle on one feature of the target.
+    std::vector<FitParameters> starts {clampToBounds(toFitParameters(current))};
+    for (auto frequency : {60.0, 150.0, 400.0, 1000.0, 2500.0, 6000.0, 12000.0}) {
+        const auto nearest = std::min_element(target.frequencies.begin(), target.frequencies.end(), [&](double a, double b) {
+            return std::abs(std::log(a / frequency)) < std::abs(std::log(b / frequency));
+        });
+        const auto index = (size_t)std::distance(target.frequencies.begin(), nearest);
+        if (target.weights[index] <= 0.0)
+            continue;
+
+        auto start = current;
+        start.lowCutFreq = 20.0f;
+        start.highCutFreq = 20000.0f;
+        start.peakFreq = (float)*nearest;
+        start.peakGainInDecibels = (float)(target.decibels[index] - meanTarget);
+        start.peakQuality = 1.0f;
+        starts.push_back(clampToBounds(toFitParameters(start)));
+    }
+
+    auto bestCost = std::numeric_limits<double>::max();
+    for (auto p : starts) {
+        const auto cost = fitFrom(problem, p);
+        if (cost < bestCost) {
+            bestCost = cost;
+            fit.settings = toChainSettings(p, current);
+        }
+    }
+    fit.rmsErrorDecibels = std::sqrt(bestCost / problem.totalWeight);
+    return fit;
+}
+
+
+//==============================================================================
+MatchAnalyser::MatchAnalyser() : juce::Thread("SimpleEQ Match") {
+}
+
+
+MatchAnalyser::~MatchAnalyser() {
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+}
+
+
+void MatchAnalyser::prepare(double sampleRate, int maximumBlockSize) {
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    mono.setSize(1, maxBlockSize);
+
+    // Spectra at a different rate would be averaged on the wrong frequencies
+    if (sampleRate != preparedSampleRate.exchange(sampleRate)) {
+        const juce::ScopedLock lock(spectrumLock);
+        inputSpectrum.reset(sampleRate);
+        sidechainSpectrum.reset(sampleRate);
+    }
+    return;
+}
+
+
+void MatchAnalyser::release() {
+    // pushMono() skips everything until the next prepare()
+    maxBlockSize = 0;
+    mono.setSize(0, 0);
+    return;
+}
+
+
+void MatchAnalyser::pushInput(const juce::AudioBuffer<float>& buffer) {
+    if (learning.load(std::memory_order_relaxed))
+        pushMono(buffer, inputFifo);
+    return;
+}
+
+
+void MatchAnalyser::pushSidechain(const juce::AudioBuffer<float>& buffer) {
+    if (learning.load(std::memory_order_relaxed))
+        pushMono(buffer, sidechainFifo);
+    return;
+}
+
+
+void MatchAnalyser::pushMono(const juce::AudioBuffer<float>& buffer, SingleChannelSampleFifo<juce::AudioBuffer<float>>& fifo) {
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), 2);
+    if (numChannels == 0 || maxBlockSize <= 0 || !fifo.isPrepared())
+        return;
+
+    // The scratch covers one prepared block, setSize() below never reallocates
+    const auto gain = 1.0f / (float)numChannels;
+    const auto numSamples = buffer.getNumSamples();
+    for (int start = 0; start < numSamples; start += maxBlockSize) {
+        const auto length = juce::jmin(maxBlockSize, numSamples - start);
+        mono.setSize(1, length, false, false, true);
+        mono.copyFrom(0, 0, buffer, 0, start, length);
+        for (int ch = 1; ch < numChannels; ch++) {
+            mono.addFrom(0, 0, buffer, ch, start, length);
+        }
+        mono.applyGain(gain);
+        fifo.update(mono);
+    }
+    return;
+}
+
+
+void MatchAnalyser::setLearning(bool shouldLearn) {
+    if (shouldLearn && !learning.load()) {
+        {
+            // The audio thread only pushes once learning is set below
+            const juce::ScopedLock lock(fifoLock);
+            if (!inputFifo.isPrepared()) {
+                inputFifo.prepare(fifoBlockSize);
+                sidechainFifo.prepare(fifoBlockSize);
+            }
+        }
+        const juce::ScopedLock lock(spectrumLock);
+        inputSpectrum.reset(preparedSampleRate.load());
+        sidechainSpectrum.reset(preparedSampleRate.load());
+    }
+    learning.store(shouldLearn);
+    if (shouldLearn)
+        startIfNeeded();
+    notify();
+    return;
+}
+
+
+void MatchAnalyser::loadReferenceFile(const juce::File& file) {
+    {
+        const juce::ScopedLock lock(fileLock);
+        pendingFile = file;
+        loadingFile.store(true);
+    }
+    startIfNeeded();
+    notify();
+    return;
+}
+
+
+juce::String MatchAnalyser::getReferenceFileName() const {
+    const juce::ScopedLock lock(spectrumLock);
+    return fileName;
+}
+
+
+double MatchAnalyser::getInputSeconds() const {
+    const juce::ScopedLock lock(spectrumLock);
+    return inputSpectrum.getSeconds();
+}
+
+
+double MatchAnalyser::getReferenceSeconds() const {
+    const juce::ScopedLock lock(spectrumLock);
+    return source.load() == MatchSource_File ? fileSpectrum.getSeconds() : sidechainSpectrum.getSeconds();
+}
+
+
+std::optional<MatchFit> MatchAnalyser::match(const ChainSettings& current, double sampleRate) const {
+    MatchTarget target;
+    {
+        const juce::ScopedLock lock(spectrumLock);
+        const auto& reference = source.load() == MatchSource_File ? fileSpectrum : sidechainSpectrum;
+        if (inputSpectrum.getNumFrames() == 0 || reference.getNumFrames() == 0)
+            return std::nullopt;
+        target = makeMatchTarget(inputSpectrum, reference);
+    }
+
+    if (std::none_of(target.weights.begin(), target.weights.end(), [](double weight) { return weight > 0.0; }))
+        return std::nullopt;
+    return fitChainSettings(target, current, sampleRate);
+}
+
+
+void MatchAnalyser::startIfNeeded() {
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+    return;
+}
+
+
+void MatchAnalyser::run() {
+    while (!threadShouldExit()) {
+        juce::File file;
+        {
+            const juce::ScopedLock lock(fileLock);
+            std::swap(file, pendingFile);
+        }
+        if (file != juce::File())
+            analyseFile(file);
+
+        pullBlocks();
+
+        // The fifos hold 320 ms of audio at 48 kHz, polling keeps well ahead of them
+        wait(learning.load() ? 20 : -1);
+    }
+    return;
+}
+
+
+void MatchAnalyser::pullBlocks() {
+    const juce::ScopedLock lock(fifoLock);
+
+    // Blocks left over from before learning stopped are dropped, not averaged into the next run
+    const auto keep = learning.load();
+    for (auto* fifo : {&inputFifo, &sidechainFifo}) {
+        auto& spectrum = fifo == &inputFifo ? inputSpectrum : sidechainSpectrum;
+        while (fifo->getNumCompleteBuffersAvailable() > 0) {
+            if (!fifo->getAudioBuffer(pulled))
+                break;
+            if (keep) {
+                const juce::ScopedLock spectrumScope(spectrumLock);
+                spectrum.process(pulled.getReadPointer(0), pulled.getNumSamples());
+            }
+        }
+    }
+    return;
+}
+
+
+void MatchAnalyser::analyseFile(const juce::File& file) {
+    const auto readable = analyseAudioFile(file, loadingSpectrum, this);
+    {
+        const juce::ScopedLock lock(spectrumLock);
+        fileSpectrum.swapAccumulated(loadingSpectrum);
+        fileName = readable ? file.getFileName() : file.getFileName() + " (unreadable)";
+    }
+    
+    // Another file may have been picked while this one was read
+    const juce::ScopedLock lock(fileLock);
+    loadingFile.store(pendingFile != juce::File());
+    return;
+}
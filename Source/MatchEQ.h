@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    MatchEQ.h
+    Derives ChainSettings that move the input's tonal balance towards a reference.
+
+    Both signals are reduced to long-term average power spectra. The gain the
+    EQ should apply is the reference minus the input in dB, smoothed to a third
+    of an octave on a log grid. Overall level is not part of the match, the fit
+    leaves a constant offset free. The continuous parameters of the chain are
+    fitted with Levenberg-Marquardt from a few starting points, slopes and cut
+    types keep their current settings.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "ResponseAnalysis.h"
+#include "SampleFifo.h"
+
+
+// Jake: Long-term average power spectrum of one signal. Frames are Hann windowed and overlap by
+// half, every frame counts the same. Nothing is allocated until the first samples arrive.
+// Not thread safe, MatchAnalyser guards its spectra.
+class AveragedSpectrum {
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    // Forgets everything, the next samples are taken to be at sampleRate
+    void reset(double sampleRate);
+    void process(const float* samples, int numSamples);
+
+    double getSampleRate() const { return sampleRate; }
+    int getNumFrames() const { return numFrames; }
+    double getSeconds() const;
+    
+    // Exchanges what was accumulated, so a spectrum can be built outside a lock and published.
+    // The FFT stays with each spectrum, process() sizes whatever buffers it gets back.
+    void swapAccumulated(AveragedSpectrum& other);
+
+    // Mean power over octaveFraction around each frequency, in dB. Frequencies the spectrum
+    // doesn't cover come out at -200 dB.
+    std::vector<double> getDecibels(const std::vector<double>& frequencies, double octaveFraction = 1.0 / 3.0) const;
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::vector<float> frame;
+    std::vector<float> workspace;
+    std::vector<double> powerSum;
+    int framePosition = 0;
+    int numFrames = 0;
+    double sampleRate = 0.0;
+
+    void addFrame();
+};
+
+
+// Jake: Resets spectrum to the file's rate and adds the mono mix of its first two channels, up to
+// ten minutes of it. Stops early when thread is given and asked to exit. False if unreadable.
+bool analyseAudioFile(const juce::File& file, AveragedSpectrum& spectrum, juce::Thread* thread = nullptr);
+
+
+// Jake: Gain in dB the EQ should apply at each frequency to match the reference. Points where
+// either spectrum is too quiet to trust get no weight.
+struct MatchTarget {
+    std::vector<double> frequencies;
+    std::vector<double> decibels;
+    std::vector<double> weights;
+};
+
+// Jake: The fitted chain and the weighted RMS error left over, in dB after the level offset
+struct MatchFit {
+    ChainSettings settings;
+    double rmsErrorDecibels = 0.0;
+};
+
+MatchTarget makeMatchTarget(const AveragedSpectrum& input, const AveragedSpectrum& reference, int numPoints = 96);
+
+// Jake: Fits cut frequencies, peak frequency, gain and quality to target at sampleRate. Slopes and
+// cut types are taken from current, which is also one of the starting points.
+MatchFit fitChainSettings(const MatchTarget& target, const ChainSettings& current, double sampleRate);
+
+// Jake: Where the reference spectrum comes from
+enum MatchSource {
+    MatchSource_Sidechain,
+    MatchSource_File,
+    NumMatchSources
+};
+
+
+// Jake: Learns the spectra to match. While learning, the audio thread pushes the mono mix of the
+// main input and of the sidechain into a SingleChannelSampleFifo each and a background thread
+// pulls the blocks and accumulates them. Reference files are read on the same thread. The thread
+// is only started once there is something to do.
+class MatchAnalyser : private juce::Thread {
+public:
+    MatchAnalyser();
+    ~MatchAnalyser() override;
+
+    // prepareToPlay: sizes the mono scratch
+    void prepare(double sampleRate, int maximumBlockSize);
+    
+    // releaseResources: frees the mono scratch. The fifos stay, learning carries on across a
+    // transport stop and the worker may still be pulling from them.
+    void release();
+
+    // Audio thread, both return straight away unless learning
+    void pushInput(const juce::AudioBuffer<float>& buffer);
+    void pushSidechain(const juce::AudioBuffer<float>& buffer);
+
+    // Message thread. Starting to learn forgets what was learned from the audio before,
+    // a loaded reference file is kept.
+    void setLearning(bool shouldLearn);
+    bool isLearning() const { return learning.load(); }
+    void setSource(MatchSource newSource) { source.store(newSource); }
+    MatchSource getSource() const { return source.load(); }
+    void loadReferenceFile(const juce::File& file);
+    bool isLoadingFile() const { return loadingFile.load(); }
+    juce::String getReferenceFileName() const;
+
+    // Any thread: seconds of audio behind each spectrum
+    double getInputSeconds() const;
+    double getReferenceSeconds() const;
+
+    // Fits on the calling thread, nothing until both spectra have some audio
+    std::optional<MatchFit> match(const ChainSettings& current, double sampleRate) const;
+
+private:
+    void run() override;
+    void pullBlocks();
+    void analyseFile(const juce::File& file);
+    void startIfNeeded();
+
+    std::atomic<bool> learning {false};
+    std::atomic<MatchSource> source {MatchSource_Sidechain};
+    std::atomic<bool> loadingFile {false};
+
+    // Audio thread side. Both fifos carry channel 0 of the mono mix in blocks of a fixed size,
+    // they are prepared once, the first time learning starts, and never resized after that.
+    static constexpr int fifoBlockSize = 512;
+    juce::AudioBuffer<float> mono;
+    int maxBlockSize = 0;
+    SingleChannelSampleFifo<juce::AudioBuffer<float>> inputFifo {Channel::Right};
+    SingleChannelSampleFifo<juce::AudioBuffer<float>> sidechainFifo {Channel::Right};
+    void pushMono(const juce::AudioBuffer<float>& buffer, SingleChannelSampleFifo<juce::AudioBuffer<float>>& fifo);
+
+    // Held while the fifos are prepared and by the worker while it pulls, the audio thread
+    // never takes it
+    juce::CriticalSection fifoLock;
+    juce::AudioBuffer<float> pulled;
+    std::atomic<double> preparedSampleRate {0.0};
+
+    // Held whenever a spectrum is touched
+    mutable juce::CriticalSection spectrumLock;
+    AveragedSpectrum inputSpectrum;
+    AveragedSpectrum sidechainSpectrum;
+    AveragedSpectrum fileSpectrum;
+    AveragedSpectrum loadingSpectrum;     // worker only
+    juce::String fileName;
+
+    juce::CriticalSection fileLock;
+    juce::File pendingFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MatchAnalyser)
+};
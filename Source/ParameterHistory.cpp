@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    ParameterHistory.cpp
+    Undo and redo of the chain settings without an UndoManager.
+
+  ==============================================================================
+*/
+
+#include "ParameterHistory.h"
+
+void ParameterHistory::beginGesture(const ChainSettings& settings) {
+    if (openGestures++ == 0) {
+        push(settings);
+        notify();
+    }
+    return;
+}
+
+
+void ParameterHistory::endGesture(const ChainSettings& settings) {
+    openGestures = juce::jmax(0, openGestures - 1);
+    if (openGestures == 0) {
+        push(settings);
+        notify();
+    }
+    return;
+}
+
+
+std::optional<ChainSettings> ParameterHistory::undo(const ChainSettings& current) {
+    push(current);
+    if (position <= 0)
+        return std::nullopt;
+    
+    position--;
+    notify();
+    return at(position);
+}
+
+
+std::optional<ChainSettings> ParameterHistory::redo(const ChainSettings& current) {
+    push(current);
+    if (position + 1 >= size)
+        return std::nullopt;
+    
+    position++;
+    notify();
+    return at(position);
+}
+
+
+void ParameterHistory::clear() {
+    first = 0;
+    size = 0;
+    position = -1;
+    openGestures = 0;
+    notify();
+    return;
+}
+
+
+void ParameterHistory::push(const ChainSettings& settings) {
+    if (position >= 0 && at(position) == settings)
+        return;
+    
+    // Anything after the current entry was undone and is replaced by the new branch
+    size = position + 1;
+    if (size == capacity) {
+        first = (first + 1) % capacity;
+        size--;
+    }
+    at(size) = settings;
+    position = size;
+    size++;
+    return;
+}
+
+
+void ParameterHistory::notify() {
+    if (onChange != nullptr)
+        onChange();
+    return;
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    ParameterHistory.h
+    Undo and redo of the chain settings without an UndoManager.
+
+    The history is a fixed ring of ChainSettings snapshots, written on the
+    message thread at gesture boundaries. Nothing here is touched by the
+    audio thread or by parameter listeners, so recording costs no ValueTree
+    transactions and restoring only sets the parameters that differ.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <functional>
+#include <optional>
+
+#include "EQDesign.h"
+
+
+// Jake: Bounded undo/redo history. One entry per gesture, overlapping gestures (several
+// parameters moved by one drag) become a single entry when the last of them ends. The oldest
+// entries are dropped once the ring is full. Message thread only.
+class ParameterHistory {
+public:
+    static constexpr int capacity = 128;
+    
+    // Called after every change of the history, for enabling undo/redo buttons
+    std::function<void()> onChange;
+    
+    // A gesture starts from settings. Changes that came in without a gesture since the last
+    // entry (automation, a loaded state) are recorded first, so undo comes back to this point.
+    void beginGesture(const ChainSettings& settings);
+    void endGesture(const ChainSettings& settings);
+    
+    // Settings to restore, nothing when there is no step in that direction. Current settings that
+    // were never recorded become an entry first, so redo can return to them.
+    std::optional<ChainSettings> undo(const ChainSettings& current);
+    std::optional<ChainSettings> redo(const ChainSettings& current);
+    
+    bool canUndo() const { return position > 0; }
+    bool canRedo() const { return position + 1 < size; }
+    
+    void clear();
+    
+private:
+    std::array<ChainSettings, capacity> entries;
+    int first = 0;          // ring index of the oldest entry
+    int size = 0;
+    int position = -1;      // entry the parameters were last known to match
+    int openGestures = 0;
+    
+    ChainSettings& at(int index) { return entries[(size_t)((first + index) % capacity)]; }
+    // Makes settings the newest entry, dropping the redo steps. No-op when they match the current one.
+    void push(const ChainSettings& settings);
+    void notify();
+};
@@ -10,59 +10,56 @@
 #include "PluginEditor.h"
 
 
+namespace {
+    const float knobStartAngle = juce::degreesToRadians(180.0f + 45.0f);
+    const float knobEndAngle = juce::degreesToRadians(180.0f - 45.0f) + juce::MathConstants<float>::twoPi;
+}
+
+
 void LookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle, juce::Slider &slider) {
     auto bounds = juce::Rectangle<float>(x,  y, width, height);
+    drawRotaryFace(g, bounds);
     
+    // draw rotary notch
+    auto center = bounds.getCentre();
+    jassert(rotaryStartAngle < rotaryEndAngle);
+    auto sliderAngleInRadians = juce::jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+    g.fillPath(createRotaryPointer(bounds, bounds.getHeight() / 4), juce::AffineTransform::rotation(sliderAngleInRadians, center.getX(), center.getY()));
+    return;
+}
+
+void LookAndFeel::drawRotaryFace(juce::Graphics& g, juce::Rectangle<float> bounds) {
     // draw rotary knob
     g.setColour(juce::Colours::blue);
     g.fillEllipse(bounds);
     g.setColour(juce::Colours::yellow);
     g.drawEllipse(bounds, 1.0);
-    
-    if (auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider)) {
-        // draw rotary notch
-        auto center = bounds.getCentre();
-        juce::Path path;
-        juce::Rectangle<float> rect;
-        rect.setLeft(center.getX() - 2);
-        rect.setRight(center.getX() + 2);
-        rect.setTop(bounds.getY());
-        rect.setBottom(center.getY() - 1.5 * rswl->getTextHeight());
-        path.addRectangle(rect);
-        jassert(rotaryStartAngle < rotaryEndAngle);
-        auto sliderAngleInRadians = juce::jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
-        path.applyTransform(juce::AffineTransform().rotation(sliderAngleInRadians, center.getX(), center.getY()));
-        g.fillPath(path);
-        
-        // draw rotary text
-        g.setFont(rswl->getTextHeight());
-        auto text = rswl->getDisplayString();
-        auto strWidth = g.getCurrentFont().getStringWidth(text);
-        rect.setSize(strWidth + 4, rswl->getTextHeight());
-        rect.setCentre(center);
-        //g.seColour(juce::Colours::black);
-        //g.fillRect(rect);
-        g.setColour(juce::Colours::yellow);
-        g.drawFittedText(text, rect.toNearestInt(), juce::Justification::centred, 1);
-    }
     return;
 }
+
+juce::Path LookAndFeel::createRotaryPointer(juce::Rectangle<float> bounds, float pointerInset) {
+    // Unrotated notch pointing up, stopping pointerInset short of the centre
+    auto center = bounds.getCentre();
+    juce::Path path;
+    juce::Rectangle<float> rect;
+    rect.setLeft(center.getX() - 2);
+    rect.setRight(center.getX() + 2);
+    rect.setTop(bounds.getY());
+    rect.setBottom(center.getY() - pointerInset);
+    path.addRectangle(rect);
+    return path;
+}
 //==============================================================================
 juce::String RotarySliderWithLabels::getDisplayString() const {
-    if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+    if (choiceParam != nullptr)
         return choiceParam->getCurrentChoiceName();
     
     juce::String string;
     bool kHz = false;
     float value = (float)getValue();
-    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param)) {
-        if (value >= 1000.0) {
-            value /= 1000.0;
-            kHz = true;
-        }
-    }
-    else {
-        jassertfalse;
+    if (value >= 1000.0) {
+        value /= 1000.0;
+        kHz = true;
     }
     
     if (kHz) {
@@ -83,20 +80,52 @@ juce::String RotarySliderWithLabels::getDisplayString() const {
 }
 
 void RotarySliderWithLabels::paint(juce::Graphics &g) {
-    float startAngle = juce::degreesToRadians(180.0 + 45.0);
-    float endAngle = juce::degreesToRadians(180.0 - 45.0) + juce::MathConstants<float>::twoPi;
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (faceCache.isNull() || scale != faceCacheScale) {
+        renderFace(scale);
+    }
+    g.drawImage(faceCache, getLocalBounds().toFloat());
+    
+    // Draw the pointer at the current value
+    auto center = getSliderBounds().toFloat().getCentre();
     auto range = getRange();
-    auto sliderBounds = getSliderBounds();
+    auto angle = juce::jmap(getValue(), range.getStart(), range.getEnd(), (double)knobStartAngle, (double)knobEndAngle);
+    g.setColour(juce::Colours::yellow);
+    g.fillPath(pointer, juce::AffineTransform::rotation((float)angle, center.getX(), center.getY()));
     
-    getLookAndFeel().drawRotarySlider(g,
-                                      sliderBounds.getX(),
-                                      sliderBounds.getY(),
-                                      sliderBounds.getWidth(),
-                                      sliderBounds.getHeight(),
-                                      juce::jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0),
-                                      startAngle,
-                                      endAngle,
-                                      *this);
+    // Draw the value text, only measured again when the value changed
+    g.setFont(getTextHeight());
+    if (getValue() != displayedValue) {
+        displayedValue = getValue();
+        displayText = getDisplayString();
+        displayTextWidth = g.getCurrentFont().getStringWidthFloat(displayText);
+    }
+    juce::Rectangle<float> rect;
+    rect.setSize(displayTextWidth + 4, getTextHeight());
+    rect.setCentre(center);
+    g.drawFittedText(displayText, rect.toNearestInt(), juce::Justification::centred, 1);
+    return;
+}
+
+void RotarySliderWithLabels::resized() {
+    juce::Slider::resized();
+    faceCache = juce::Image();
+    return;
+}
+
+void RotarySliderWithLabels::renderFace(float scale) {
+    auto bounds = getLocalBounds();
+    faceCacheScale = scale;
+    faceCache = juce::Image(juce::Image::PixelFormat::ARGB,
+                            juce::jmax(1, juce::roundToInt(bounds.getWidth() * scale)),
+                            juce::jmax(1, juce::roundToInt(bounds.getHeight() * scale)),
+                            true);
+    juce::Graphics g(faceCache);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    
+    auto sliderBounds = getSliderBounds();
+    lnf.drawRotaryFace(g, sliderBounds.toFloat());
+    pointer = lnf.createRotaryPointer(sliderBounds.toFloat(), 1.5f * getTextHeight());
     
     // Draw dial labels
     auto center = sliderBounds.toFloat().getCentre();
@@ -108,13 +137,12 @@ void RotarySliderWithLabels::paint(juce::Graphics &g) {
         float pos = labels[i].pos;
         jassert(pos >= 0.0);
         jassert(pos <= 1.0);
-        float angle = juce::jmap(pos, 0.0f, 1.0f, startAngle, endAngle);
+        float angle = juce::jmap(pos, 0.0f, 1.0f, knobStartAngle, knobEndAngle);
         auto labelCenter = center.getPointOnCircumference(radius + getTextHeight(), angle);
         juce::Rectangle<float> rect;
         auto label = labels[i].label;
         rect.setSize(g.getCurrentFont().getStringWidth(label), getTextHeight());
         rect.setCentre(labelCenter);
-        //rect.setY(rect.getY() - getTextHeight());
         g.drawFittedText(label, rect.toNearestInt(), juce::Justification::centred, 1);
     }
     return;
@@ -136,96 +164,207 @@ ResponseCurve::ResponseCurve(SimpleEQAudioProcessor& p) : audioProcessor(p) {
     for (auto param : params) {
         param->addListener(this);
     }
-    startTimerHz(60);
+    refreshScheduler->addClient(*this);
+    responseWorker.onResultReady = [this] { refreshScheduler->requestRefresh(*this); };
     
     // Perform first chain update.
-    updateChain();
+    updateChain(getChainSettings(audioProcessor.aptvs));
 }
 
 ResponseCurve::~ResponseCurve() {
+    // Don't leave a host gesture open
+    if (wheelParameter != nullptr)
+        wheelParameter->endChangeGesture();
+    for (auto* parameter : getDragParameters(draggedBand)) {
+        parameter->endChangeGesture();
+    }
+    
     const auto& params = audioProcessor.getParameters();
     for (auto param : params) {
         param->removeListener(this);
     }
+    refreshScheduler->removeClient(*this);
 }
 
 void ResponseCurve::parameterValueChanged(int parameterIndex, float newValue) {
+    // May come from the audio thread, which only sets flags here. The scheduler posts a
+    // single wake up for them when it is idle.
     parametersChanged.set(true);
+    refreshScheduler->requestRefresh(*this);
 }
 
-void ResponseCurve::timerCallback() {
+void ResponseCurve::parameterGestureChanged(int parameterIndex, bool gestureIsStarting) {
+    // Hosts begin and end gestures of their own controls on the message thread, anything
+    // else isn't an edit worth an undo step
+    juce::ignoreUnused(parameterIndex);
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        audioProcessor.chainGestureChanged(gestureIsStarting);
+    return;
+}
+
+void ResponseCurve::refresh() {
     if (parametersChanged.compareAndSetBool(false, true)) {
-        updateChain();
-        repaint();
+        // Only the strip the curve and the handles moved through needs repainting
+        auto dirty = responsePath.getBounds().getUnion(getAllHandleBounds());
+        auto chainSettings = getChainSettings(audioProcessor.aptvs);
+        updateChain(chainSettings);
+        updateResponsePath();
+        dirty = dirty.getUnion(responsePath.getBounds()).getUnion(getAllHandleBounds()).expanded(2.0f);
+        repaint(dirty.getSmallestIntegerContainer());
+        
+        requestOverlays(chainSettings);
+    }
+    
+    // The worker finished a new phase/group delay result
+    if (responseWorker.getGeneration() != drawnGeneration) {
+        updateOverlayPaths();
+        repaint(getAnalysisArea());
     }
 }
 
-void ResponseCurve::updateChain() {
-    auto chainSettings = getChainSettings(audioProcessor.aptvs);
-    auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficents(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+void ResponseCurve::visibilityChanged() {
+    // Changes made while hidden were skipped, catch up now
+    if (isShowing()) {
+        parametersChanged.set(true);
+        refreshScheduler->requestRefresh(*this);
+    }
+}
+
+void ResponseCurve::setShowPhase(bool shouldShow) {
+    showPhase = shouldShow;
+    requestOverlays(getChainSettings(audioProcessor.aptvs));
+    updateOverlayPaths();
+    repaint(getAnalysisArea());
+}
+
+void ResponseCurve::setShowGroupDelay(bool shouldShow) {
+    showGroupDelay = shouldShow;
+    requestOverlays(getChainSettings(audioProcessor.aptvs));
+    updateOverlayPaths();
+    repaint(getAnalysisArea());
+}
+
+void ResponseCurve::requestOverlays(const ChainSettings& chainSettings) {
+    // Nothing to compute while both overlays are off
+    if ((showPhase || showGroupDelay) && !columnFrequencies.empty())
+        responseWorker.request(chainSettings, audioProcessor.getSampleRate(), columnFrequencies);
+}
+
+void ResponseCurve::updateOverlayPaths() {
+    phasePath.clear();
+    groupDelayPath.clear();
+    
+    auto responseArea = getAnalysisArea().toFloat();
+    const auto top = responseArea.getY();
+    const auto bottom = responseArea.getBottom();
+    
+    // Phase spans the full height for -pi..pi, group delay 0..20 ms from the bottom
+    responseWorker.readLatest([&](const ChainResponse& response) {
+        drawnGeneration = responseWorker.getGeneration();
+        if (response.frequencies.size() != columnFrequencies.size())
+            return;
+        
+        for (size_t i = 0; i < response.frequencies.size(); i++) {
+            auto x = responseArea.getX() + (float)i;
+            if (showPhase) {
+                auto y = juce::jmap((float)response.phaseRadians[i], -juce::MathConstants<float>::pi, juce::MathConstants<float>::pi, bottom, top);
+                if (i == 0) phasePath.startNewSubPath(x, y);
+                else phasePath.lineTo(x, y);
+            }
+            if (showGroupDelay) {
+                auto delay = juce::jlimit(0.0f, 0.02f, (float)response.groupDelaySeconds[i]);
+                auto y = juce::jmap(delay, 0.0f, 0.02f, bottom, top);
+                if (i == 0) groupDelayPath.startNewSubPath(x, y);
+                else groupDelayPath.lineTo(x, y);
+            }
+        }
+    });
+}
+
+void ResponseCurve::updateChain(const ChainSettings& newSettings) {
+    bandChanged[Band_LowCut] = bandChanged[Band_LowCut] || newSettings.lowCutFreq != chainSettings.lowCutFreq
+        || newSettings.lowCutSlope != chainSettings.lowCutSlope || newSettings.lowCutType != chainSettings.lowCutType;
+    bandChanged[Band_Peak] = bandChanged[Band_Peak] || newSettings.peakFreq != chainSettings.peakFreq
+        || newSettings.peakGainInDecibels != chainSettings.peakGainInDecibels || newSettings.peakQuality != chainSettings.peakQuality;
+    bandChanged[Band_HighCut] = bandChanged[Band_HighCut] || newSettings.highCutFreq != chainSettings.highCutFreq
+        || newSettings.highCutSlope != chainSettings.highCutSlope || newSettings.highCutType != chainSettings.highCutType;
+    
+    chainSettings = newSettings;
+    chainCoefficients = makeChainCoefficients(chainSettings, audioProcessor.getSampleRate());
     return;
 }
 
+ChainCoefficients ResponseCurve::getBandCoefficients(int band) const {
+    // Default coefficients are a neutral peak and empty cuts
+    ChainCoefficients coefficients;
+    if (band == Band_LowCut)
+        coefficients.lowCut = chainCoefficients.lowCut;
+    else if (band == Band_Peak)
+        coefficients.peak = chainCoefficients.peak;
+    else if (band == Band_HighCut)
+        coefficients.highCut = chainCoefficients.highCut;
+    return coefficients;
+}
+
 void ResponseCurve::paint (juce::Graphics& g)
 {
     // Draw Magnitude Response
     g.drawImage(background, getLocalBounds().toFloat());
     
+    if (showPhase) {
+        g.setColour(juce::Colours::cyan.withAlpha(0.7f));
+        g.strokePath(phasePath, juce::PathStrokeType(1.0));
+    }
+    if (showGroupDelay) {
+        g.setColour(juce::Colours::orange.withAlpha(0.7f));
+        g.strokePath(groupDelayPath, juce::PathStrokeType(1.0));
+    }
+    
+    g.setColour(juce::Colours::yellow);
+    g.strokePath(responsePath, juce::PathStrokeType(1.0));
+    
+    for (int band = 0; band < NumBands; band++) {
+        const auto bounds = getHandleBounds(band);
+        const auto active = band == hoveredBand || band == draggedBand;
+        g.setColour(band == Band_Peak ? juce::Colours::white : juce::Colours::yellow);
+        if (active)
+            g.fillEllipse(bounds);
+        else
+            g.drawEllipse(bounds, 1.5f);
+    }
+}
+
+void ResponseCurve::updateResponsePath() {
     auto responseArea = getAnalysisArea();
     auto W = responseArea.getWidth();
+    responsePath.clear();
+    if (W <= 0)
+        return;
     
-    auto& lowCut = monoChain.get<ChainPositions::LowCut>();
-    auto& highCut = monoChain.get<ChainPositions::HighCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
     auto sampleRate = audioProcessor.getSampleRate();
     
-    std::vector<double> mags;
-    mags.resize(responseArea.getWidth());
+    // A new grid or rate invalidates every cached band
+    if ((int)columnFrequencies.size() != W || sampleRate != evaluatorSampleRate) {
+        columnFrequencies = makeLogFrequencyGrid(W);
+        columnEvaluator.prepare(columnFrequencies, sampleRate);
+        evaluatorSampleRate = sampleRate;
+        chainCoefficients = makeChainCoefficients(chainSettings, sampleRate);
+        bandChanged.fill(true);
+    }
     
-    for (int i = 0; i < W; i++) {
-        double mag = 1.0f;
-        auto freq = juce::mapToLog10(double(i) / W, 20.0, 20000.0);
-        
-        // Get magnitude by multiplying value for all filters
-        if (!monoChain.isBypassed<ChainPositions::Peak>()) {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        
-        if (!lowCut.isBypassed<0>()) {
-            mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!lowCut.isBypassed<1>()) {
-            mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!lowCut.isBypassed<2>()) {
-            mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!lowCut.isBypassed<3>()) {
-            mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        
-        if (!highCut.isBypassed<0>()) {
-            mag *= highCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!highCut.isBypassed<1>()) {
-            mag *= highCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!highCut.isBypassed<2>()) {
-            mag *= highCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        if (!highCut.isBypassed<3>()) {
-            mag *= highCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        
-        mags[i] = juce::Decibels::gainToDecibels(mag);
+    for (int band = 0; band < NumBands; band++) {
+        if (!bandChanged[(size_t)band])
+            continue;
+        auto& decibels = bandDecibels[(size_t)band];
+        decibels.resize((size_t)W);
+        columnEvaluator.getDecibels(getBandCoefficients(band), decibels.data());
+        bandChanged[(size_t)band] = false;
     }
     
-    juce::Path responseCurve;
+    mags.resize(responseArea.getWidth());
+    for (size_t i = 0; i < mags.size(); i++) {
+        mags[i] = juce::jmax(-100.0, bandDecibels[Band_LowCut][i] + bandDecibels[Band_Peak][i] + bandDecibels[Band_HighCut][i]);
+    }
     
     const double outputMin = responseArea.getBottom();
     const double outputMax = responseArea.getY();
@@ -233,14 +372,12 @@ void ResponseCurve::paint (juce::Graphics& g)
         return juce::jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
     
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    responsePath.startNewSubPath(responseArea.getX(), map(mags.front()));
     
     for (size_t i = 1; i < mags.size(); ++i) {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
-        
+        responsePath.lineTo(responseArea.getX() + i, map(mags[i]));
     }
-    g.setColour(juce::Colours::yellow);
-    g.strokePath(responseCurve, juce::PathStrokeType(1.0));
+    return;
 }
 
 void ResponseCurve::resized() {
@@ -341,6 +478,163 @@ void ResponseCurve::resized() {
     g.setColour(juce::Colours::yellow);
     g.drawRoundedRectangle(displayArea.toFloat(), 1, 2);
     
+    updateResponsePath();
+    requestOverlays(getChainSettings(audioProcessor.aptvs));
+    return;
+}
+
+juce::Point<float> ResponseCurve::getHandlePosition(int band) {
+    const auto area = getAnalysisArea().toFloat();
+    const auto frequency = band == Band_LowCut ? chainSettings.lowCutFreq
+                         : band == Band_Peak ? chainSettings.peakFreq
+                         : chainSettings.highCutFreq;
+    const auto x = area.getX() + area.getWidth() * juce::mapFromLog10(juce::jlimit(20.0f, 20000.0f, frequency), 20.0f, 20000.0f);
+    
+    // The peak sits at its gain, the cuts on the curve at their frequency
+    auto decibels = (double)chainSettings.peakGainInDecibels;
+    if (band != Band_Peak) {
+        const auto column = juce::jlimit(0, juce::jmax(0, (int)mags.size() - 1), (int)(x - area.getX()));
+        decibels = mags.empty() ? 0.0 : mags[(size_t)column];
+    }
+    const auto y = juce::jmap((float)juce::jlimit(-24.0, 24.0, decibels), -24.0f, 24.0f, area.getBottom(), area.getY());
+    return {x, y};
+}
+
+juce::Rectangle<float> ResponseCurve::getHandleBounds(int band) {
+    return juce::Rectangle<float>(2.0f * handleRadius, 2.0f * handleRadius).withCentre(getHandlePosition(band));
+}
+
+juce::Rectangle<float> ResponseCurve::getAllHandleBounds() {
+    auto bounds = getHandleBounds(Band_LowCut);
+    for (int band = 1; band < NumBands; band++) {
+        bounds = bounds.getUnion(getHandleBounds(band));
+    }
+    return bounds;
+}
+
+int ResponseCurve::getBandAt(juce::Point<float> position) {
+    // Nearest handle within a little more than its radius, the peak wins ties
+    auto nearest = (int)Band_None;
+    auto nearestDistance = 2.0f * handleRadius;
+    for (auto band : {Band_Peak, Band_LowCut, Band_HighCut}) {
+        const auto distance = position.getDistanceFrom(getHandlePosition(band));
+        if (distance < nearestDistance) {
+            nearest = band;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+std::vector<juce::RangedAudioParameter*> ResponseCurve::getDragParameters(int band) const {
+    auto& apvts = audioProcessor.aptvs;
+    if (band == Band_LowCut)
+        return {apvts.getParameter("Low-Cut Freq")};
+    if (band == Band_Peak)
+        return {apvts.getParameter("Peak Freq"), apvts.getParameter("Peak Gain")};
+    if (band == Band_HighCut)
+        return {apvts.getParameter("High-Cut Freq")};
+    return {};
+}
+
+void ResponseCurve::setParameterValue(juce::RangedAudioParameter& parameter, float value) {
+    // The listener picks the change up and the curve follows on the next refresh tick
+    const auto normalised = parameter.convertTo0to1(value);
+    if (normalised != parameter.getValue())
+        parameter.setValueNotifyingHost(normalised);
+    return;
+}
+
+void ResponseCurve::setHoveredBand(int band) {
+    if (band == hoveredBand)
+        return;
+    
+    auto dirty = getHandleBounds(band == Band_None ? hoveredBand : band);
+    if (hoveredBand != Band_None)
+        dirty = dirty.getUnion(getHandleBounds(hoveredBand));
+    hoveredBand = band;
+    setMouseCursor(band == Band_None ? juce::MouseCursor::NormalCursor : juce::MouseCursor::DraggingHandCursor);
+    repaint(dirty.expanded(2.0f).getSmallestIntegerContainer());
+    return;
+}
+
+void ResponseCurve::mouseMove(const juce::MouseEvent& event) {
+    setHoveredBand(getBandAt(event.position));
+    return;
+}
+
+void ResponseCurve::mouseExit(const juce::MouseEvent&) {
+    setHoveredBand(Band_None);
+    return;
+}
+
+void ResponseCurve::mouseDown(const juce::MouseEvent& event) {
+    draggedBand = getBandAt(event.position);
+    for (auto* parameter : getDragParameters(draggedBand)) {
+        parameter->beginChangeGesture();
+    }
+    return;
+}
+
+void ResponseCurve::mouseDrag(const juce::MouseEvent& event) {
+    if (draggedBand == Band_None)
+        return;
+    
+    const auto area = getAnalysisArea().toFloat();
+    const auto position = event.position;
+    const auto normalisedX = juce::jlimit(0.0f, 1.0f, (position.x - area.getX()) / juce::jmax(1.0f, area.getWidth()));
+    const auto frequency = juce::mapToLog10(normalisedX, 20.0f, 20000.0f);
+    const auto parameters = getDragParameters(draggedBand);
+    setParameterValue(*parameters[0], frequency);
+    if (draggedBand == Band_Peak)
+        setParameterValue(*parameters[1], juce::jmap(position.y, area.getBottom(), area.getY(), -24.0f, 24.0f));
+    return;
+}
+
+void ResponseCurve::mouseUp(const juce::MouseEvent& event) {
+    for (auto* parameter : getDragParameters(draggedBand)) {
+        parameter->endChangeGesture();
+    }
+    draggedBand = Band_None;
+    setHoveredBand(getBandAt(event.position));
+    repaint(getAllHandleBounds().expanded(2.0f).getSmallestIntegerContainer());
+    return;
+}
+
+void ResponseCurve::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) {
+    const auto band = getBandAt(event.position);
+    if (band == Band_None || wheel.deltaY == 0.0f) {
+        Component::mouseWheelMove(event, wheel);
+        return;
+    }
+    
+    auto& apvts = audioProcessor.aptvs;
+    auto* parameter = band == Band_LowCut ? apvts.getParameter("Low-Cut Slope")
+                    : band == Band_Peak ? apvts.getParameter("Peak Quality")
+                    : apvts.getParameter("High-Cut Slope");
+    if (parameter != wheelParameter) {
+        if (wheelParameter != nullptr)
+            wheelParameter->endChangeGesture();
+        wheelParameter = parameter;
+        wheelParameter->beginChangeGesture();
+    }
+    
+    // Quality moves by a ratio, a slope by one step per notch
+    const auto direction = (wheel.deltaY > 0.0f) != wheel.isReversed ? 1.0f : -1.0f;
+    const auto current = parameter->convertFrom0to1(parameter->getValue());
+    if (band == Band_Peak)
+        setParameterValue(*parameter, current * std::pow(1.25f, direction));
+    else
+        setParameterValue(*parameter, current + direction);
+    startTimer(wheelGestureMilliseconds);
+    return;
+}
+
+void ResponseCurve::timerCallback() {
+    stopTimer();
+    if (wheelParameter != nullptr)
+        wheelParameter->endChangeGesture();
+    wheelParameter = nullptr;
     return;
 }
 
@@ -357,6 +651,210 @@ juce::Rectangle<int> ResponseCurve::getAnalysisArea() {
     return bounds;
 }
 
+//==============================================================================
+LevelMeterDisplay::LevelMeterDisplay(LevelMeter& levelMeter, const juce::String& meterName) : meter(levelMeter), name(meterName) {
+    peakDecibels.fill(minDecibels);
+    rmsDecibels.fill(minDecibels);
+    truePeakHoldDecibels.fill(minDecibels);
+    
+    meter.onChange = [this] { refreshScheduler->requestRefresh(*this); };
+    meter.requestWakeOnChange();
+    meter.setEnabled(true);
+    refreshScheduler->addClient(*this);
+}
+
+LevelMeterDisplay::~LevelMeterDisplay() {
+    refreshScheduler->removeClient(*this);
+    meter.setEnabled(false);
+    meter.onChange = nullptr;
+}
+
+void LevelMeterDisplay::refresh() {
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto elapsedSeconds = lastRefreshTime > 0.0 ? (float)(0.001 * (now - lastRefreshTime)) : 0.0f;
+    lastRefreshTime = now;
+    
+    // Anything the readouts or bars can show counts as a change, smaller steps are skipped
+    auto hasChanged = false;
+    const auto update = [&hasChanged] (float& value, float newValue) {
+        hasChanged = hasChanged || std::abs(newValue - value) >= 0.05f;
+        value = newValue;
+    };
+    
+    const auto changeCount = meter.getChangeCount();
+    const auto readings = meter.getReadings();
+    for (size_t ch = 0; ch < peakDecibels.size(); ch++) {
+        const auto fallback = peakDecibels[ch] - peakFallbackDecibelsPerSecond * elapsedSeconds;
+        update(peakDecibels[ch], juce::jmax(juce::Decibels::gainToDecibels(readings.peak[ch], minDecibels), fallback));
+        update(rmsDecibels[ch], juce::Decibels::gainToDecibels(readings.rms[ch], minDecibels));
+        update(truePeakHoldDecibels[ch], juce::jmax(truePeakHoldDecibels[ch], juce::Decibels::gainToDecibels(readings.truePeak[ch], minDecibels)));
+    }
+    update(momentaryLoudness, readings.momentaryLoudness);
+    update(shortTermLoudness, readings.shortTermLoudness);
+    if (clipper != nullptr) {
+        const auto newClipCount = clipper->getClipCount() - clipCountAtReset;
+        hasChanged = hasChanged || newClipCount != clipCount;
+        clipCount = newClipCount;
+    }
+    
+    isAnimating = hasChanged;
+    if (!isAnimating) {
+        // Ask the meter for a wake up. A change it counted since the readings were taken keeps
+        // the tick running instead, so it can't slip in between.
+        meter.requestWakeOnChange();
+        isAnimating = meter.getChangeCount() != changeCount;
+        // The peaks start falling from the next change, not from the time spent waiting
+        if (!isAnimating)
+            lastRefreshTime = 0.0;
+    }
+    
+    if (hasChanged)
+        repaint();
+    return;
+}
+
+void LevelMeterDisplay::visibilityChanged() {
+    // Don't let the peaks fall back over the time spent hidden, and restart the tick
+    lastRefreshTime = 0.0;
+    if (isShowing())
+        refreshScheduler->requestRefresh(*this);
+    return;
+}
+
+void LevelMeterDisplay::mouseDown(const juce::MouseEvent&) {
+    truePeakHoldDecibels.fill(minDecibels);
+    meter.resetTruePeakHold();
+    if (clipper != nullptr)
+        clipCountAtReset = clipper->getClipCount();
+    clipCount = 0;
+    repaint();
+    return;
+}
+
+void LevelMeterDisplay::setSoftClipper(const SoftClipper* softClipper) {
+    clipper = softClipper;
+    clipCountAtReset = clipper != nullptr ? clipper->getClipCount() : 0;
+    clipCount = 0;
+    return;
+}
+
+void LevelMeterDisplay::paint(juce::Graphics& g) {
+    auto bounds = getLocalBounds().reduced(4);
+    g.setFont(11.0f);
+    
+    g.setColour(juce::Colours::white);
+    g.drawFittedText(name, bounds.removeFromLeft(28), juce::Justification::centredLeft, 1);
+    
+    // One bar per channel, RMS filled and peak as a line, scaled minDecibels..0 dBFS
+    auto barArea = bounds.removeFromLeft(bounds.getWidth() / 2).reduced(0, 2);
+    const auto barHeight = barArea.getHeight() / (int)peakDecibels.size();
+    for (size_t ch = 0; ch < peakDecibels.size(); ch++) {
+        auto bar = barArea.removeFromTop(barHeight).reduced(0, 1).toFloat();
+        g.setColour(juce::Colours::black);
+        g.fillRect(bar);
+        
+        const auto rmsX = juce::jmap(rmsDecibels[ch], minDecibels, 0.0f, bar.getX(), bar.getRight());
+        const auto peakX = juce::jmap(juce::jmin(peakDecibels[ch], 0.0f), minDecibels, 0.0f, bar.getX(), bar.getRight());
+        g.setColour(juce::Colours::limegreen);
+        g.fillRect(bar.withRight(juce::jmin(rmsX, bar.getRight())));
+        g.setColour(peakDecibels[ch] >= 0.0f ? juce::Colours::red : juce::Colours::yellow);
+        g.drawVerticalLine((int)peakX, bar.getY(), bar.getBottom());
+    }
+    
+    auto truePeak = juce::jmax(truePeakHoldDecibels[0], truePeakHoldDecibels[1]);
+    juce::String text;
+    text << "TP " << juce::String(truePeak, 1) << "  M " << juce::String(momentaryLoudness, 1)
+         << "  S " << juce::String(shortTermLoudness, 1) << " LUFS";
+    if (clipCount > 0)
+        text << "  CLIP " << juce::String((juce::int64)clipCount);
+    g.setColour(truePeak > 0.0f || clipCount > 0 ? juce::Colours::red : juce::Colours::white);
+    g.drawFittedText(text, bounds.withTrimmedLeft(6), juce::Justification::centredLeft, 1);
+    return;
+}
+
+MatchStrip::MatchStrip(SimpleEQAudioProcessor& processor) : audioProcessor(processor), analyser(processor.getMatchAnalyser()) {
+    sourceBox.addItemList({"Sidechain", "Reference File"}, 1);
+    sourceBox.setSelectedItemIndex((int)analyser.getSource(), juce::dontSendNotification);
+    sourceBox.onChange = [this] {
+        analyser.setSource(static_cast<MatchSource>(sourceBox.getSelectedItemIndex()));
+        refresh();
+    };
+    
+    learnButton.setToggleState(analyser.isLearning(), juce::dontSendNotification);
+    learnButton.onClick = [this] {
+        analyser.setLearning(learnButton.getToggleState());
+        refreshScheduler->requestRefresh(*this);
+    };
+    loadButton.onClick = [this] { chooseFile(); };
+    matchButton.onClick = [this] { applyMatch(); };
+    statusLabel.setFont(juce::Font(11.0f));
+    
+    for (auto* comp : std::initializer_list<juce::Component*> {&learnButton, &sourceBox, &loadButton, &matchButton, &statusLabel}) {
+        addAndMakeVisible(comp);
+    }
+    refreshScheduler->addClient(*this);
+    refresh();
+}
+
+MatchStrip::~MatchStrip() {
+    refreshScheduler->removeClient(*this);
+}
+
+bool MatchStrip::wantsContinuousRefresh() const {
+    return wasBusy || analyser.isLearning() || analyser.isLoadingFile();
+}
+
+void MatchStrip::refresh() {
+    wasBusy = analyser.isLearning() || analyser.isLoadingFile();
+    
+    juce::String status;
+    status << "In " << juce::String(analyser.getInputSeconds(), 1) << " s, ";
+    if (analyser.getSource() == MatchSource_File) {
+        const auto name = analyser.getReferenceFileName();
+        status << (analyser.isLoadingFile() ? juce::String("reading file") : name.isEmpty() ? juce::String("no file") : name);
+        status << " " << juce::String(analyser.getReferenceSeconds(), 1) << " s";
+    }
+    else {
+        status << "sidechain " << juce::String(analyser.getReferenceSeconds(), 1) << " s";
+    }
+    if (lastResult.isNotEmpty())
+        status << "  |  " << lastResult;
+    statusLabel.setText(status, juce::dontSendNotification);
+    return;
+}
+
+void MatchStrip::resized() {
+    auto bounds = getLocalBounds().reduced(4, 2);
+    learnButton.setBounds(bounds.removeFromLeft(70));
+    sourceBox.setBounds(bounds.removeFromLeft(120));
+    loadButton.setBounds(bounds.removeFromLeft(90).withTrimmedLeft(4));
+    matchButton.setBounds(bounds.removeFromLeft(70).withTrimmedLeft(4));
+    statusLabel.setBounds(bounds.withTrimmedLeft(4));
+    return;
+}
+
+void MatchStrip::chooseFile() {
+    fileChooser = std::make_unique<juce::FileChooser>("Reference recording", juce::File(), "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles, [this](const juce::FileChooser& chooser) {
+        const auto file = chooser.getResult();
+        if (file == juce::File())
+            return;
+        
+        analyser.loadReferenceFile(file);
+        sourceBox.setSelectedItemIndex(MatchSource_File);
+        refreshScheduler->requestRefresh(*this);
+    });
+    return;
+}
+
+void MatchStrip::applyMatch() {
+    const auto fit = audioProcessor.applyMatch();
+    lastResult = fit.has_value() ? "matched, " + juce::String(fit->rmsErrorDecibels, 1) + " dB rms left"
+                                 : juce::String("learn input and reference first");
+    refresh();
+    return;
+}
+
 //==============================================================================
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor& p)
     : AudioProcessorEditor (&p),
@@ -370,6 +868,10 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
       highCutFreqSlider(*audioProcessor.aptvs.getParameter("High-Cut Freq"), "Hz"),
       lowCutSlopeSlider(*audioProcessor.aptvs.getParameter("Low-Cut Slope"), "dB/Oct"),
       highCutSlopeSlider(*audioProcessor.aptvs.getParameter("High-Cut Slope"), "dB/Oct"),
+      lowCutTypeBox(*audioProcessor.aptvs.getParameter("Low-Cut Type")),
+      highCutTypeBox(*audioProcessor.aptvs.getParameter("High-Cut Type")),
+      crossoverBandsBox(*audioProcessor.aptvs.getParameter("Crossover Bands")),
+      crossoverSlopeBox(*audioProcessor.aptvs.getParameter("Crossover Slope")),
 
       peakFreqSliderAttachment(audioProcessor.aptvs, "Peak Freq", peakFreqSlider),
       peakGainSliderAttachment(audioProcessor.aptvs, "Peak Gain", peakGainSlider),
@@ -377,9 +879,22 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
       lowCutFreqSliderAttachment(audioProcessor.aptvs, "Low-Cut Freq", lowCutFreqSlider),
       highCutFreqSliderAttachment(audioProcessor.aptvs, "High-Cut Freq", highCutFreqSlider),
       lowCutSlopeSliderAttachment(audioProcessor.aptvs, "Low-Cut Slope", lowCutSlopeSlider),
-      highCutSlopeSliderAttachment(audioProcessor.aptvs, "High-Cut Slope", highCutSlopeSlider)
+      highCutSlopeSliderAttachment(audioProcessor.aptvs, "High-Cut Slope", highCutSlopeSlider),
+      autoGainButtonAttachment(audioProcessor.aptvs, "Auto Gain", autoGainButton),
+      softClipButtonAttachment(audioProcessor.aptvs, "Soft Clip", softClipButton),
+      lowCutTypeBoxAttachment(audioProcessor.aptvs, "Low-Cut Type", lowCutTypeBox),
+      highCutTypeBoxAttachment(audioProcessor.aptvs, "High-Cut Type", highCutTypeBox),
+      crossoverBandsBoxAttachment(audioProcessor.aptvs, "Crossover Bands", crossoverBandsBox),
+      crossoverSlopeBoxAttachment(audioProcessor.aptvs, "Crossover Slope", crossoverSlopeBox),
+      crossoverFreq1SliderAttachment(audioProcessor.aptvs, "Crossover Freq 1", crossoverFreq1Slider),
+      crossoverFreq2SliderAttachment(audioProcessor.aptvs, "Crossover Freq 2", crossoverFreq2Slider),
+      crossoverFreq3SliderAttachment(audioProcessor.aptvs, "Crossover Freq 3", crossoverFreq3Slider),
+
+      inputMeterDisplay(audioProcessor.getInputMeter(), "IN"),
+      outputMeterDisplay(audioProcessor.getOutputMeter(), "OUT"),
+      matchStrip(audioProcessor)
 {
-    setSize (700, 600);
+    setSize (700, 696);
     
     peakFreqSlider.labels.add({0.0, "20"});
     peakFreqSlider.labels.add({1.0, "20k"});
@@ -391,10 +906,25 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
     lowCutFreqSlider.labels.add({1.0, "20k"});
     highCutFreqSlider.labels.add({0.0, "20"});
     highCutFreqSlider.labels.add({1.0, "20k"});
-    lowCutSlopeSlider.labels.add({0.0, "12"});
-    lowCutSlopeSlider.labels.add({1.0, "48"});
-    highCutSlopeSlider.labels.add({0.0, "12"});
-    highCutSlopeSlider.labels.add({1.0, "48"});
+    lowCutSlopeSlider.labels.add({0.0, "6"});
+    lowCutSlopeSlider.labels.add({1.0, "96"});
+    highCutSlopeSlider.labels.add({0.0, "6"});
+    highCutSlopeSlider.labels.add({1.0, "96"});
+    
+    phaseButton.onClick = [this] { responseCurve.setShowPhase(phaseButton.getToggleState()); };
+    groupDelayButton.onClick = [this] { responseCurve.setShowGroupDelay(groupDelayButton.getToggleState()); };
+    outputMeterDisplay.setSoftClipper(&audioProcessor.getSoftClipper());
+    
+    undoButton.onClick = [this] { audioProcessor.undoChainSettings(); };
+    redoButton.onClick = [this] { audioProcessor.redoChainSettings(); };
+    audioProcessor.setHistoryListener([this] { updateHistoryButtons(); });
+    updateHistoryButtons();
+    setWantsKeyboardFocus(true);
+    
+    for (auto* slider : {&crossoverFreq1Slider, &crossoverFreq2Slider, &crossoverFreq3Slider}) {
+        slider->setSliderStyle(juce::Slider::LinearBar);
+        slider->setTextValueSuffix(" Hz");
+    }
     
     for (auto& comp : getComponents()) {
         addAndMakeVisible(comp);
@@ -403,6 +933,7 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
 {
+    audioProcessor.setHistoryListener(nullptr);
 }
 
 //==============================================================================
@@ -417,6 +948,19 @@ void SimpleEQAudioProcessorEditor::resized()
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
     auto bounds = getLocalBounds();
+    auto meterArea = bounds.removeFromBottom(40);
+    inputMeterDisplay.setBounds(meterArea.removeFromLeft(meterArea.getWidth() / 2));
+    outputMeterDisplay.setBounds(meterArea);
+    
+    auto crossoverArea = bounds.removeFromBottom(28).reduced(4, 2);
+    crossoverBandsBox.setBounds(crossoverArea.removeFromLeft(100));
+    crossoverSlopeBox.setBounds(crossoverArea.removeFromLeft(100).withTrimmedLeft(4));
+    const auto freqWidth = crossoverArea.getWidth() / 3;
+    crossoverFreq1Slider.setBounds(crossoverArea.removeFromLeft(freqWidth).withTrimmedLeft(4));
+    crossoverFreq2Slider.setBounds(crossoverArea.removeFromLeft(freqWidth).withTrimmedLeft(4));
+    crossoverFreq3Slider.setBounds(crossoverArea.withTrimmedLeft(4));
+    matchStrip.setBounds(bounds.removeFromBottom(28));
+    
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 1/2);
     auto lowCutArea = bounds.removeFromLeft(bounds.getWidth() * 1/3);
     auto highCutArea = bounds.removeFromRight(bounds.getWidth() * 1/2);
@@ -427,9 +971,19 @@ void SimpleEQAudioProcessorEditor::resized()
     auto highCutFreqArea = highCutArea.removeFromTop(highCutArea.getHeight() * 1/2);
     
     responseCurve.setBounds(responseArea);
+    auto overlayArea = responseArea.reduced(14).removeFromTop(20).removeFromRight(320);
+    groupDelayButton.setBounds(overlayArea.removeFromRight(70));
+    phaseButton.setBounds(overlayArea.removeFromRight(70));
+    softClipButton.setBounds(overlayArea.removeFromRight(90));
+    autoGainButton.setBounds(overlayArea);
+    auto historyArea = responseArea.reduced(14).removeFromTop(20).removeFromLeft(104);
+    undoButton.setBounds(historyArea.removeFromLeft(50));
+    redoButton.setBounds(historyArea.withTrimmedLeft(4));
     lowCutFreqSlider.setBounds(lowCutFreqArea);
+    lowCutTypeBox.setBounds(lowCutArea.removeFromBottom(28).reduced(16, 2));
     lowCutSlopeSlider.setBounds(lowCutArea);
     highCutFreqSlider.setBounds(highCutFreqArea);
+    highCutTypeBox.setBounds(highCutArea.removeFromBottom(28).reduced(16, 2));
     highCutSlopeSlider.setBounds(highCutArea);
     peakFreqSlider.setBounds(peakFreqArea);
     peakGainSlider.setBounds(peakGainArea);
@@ -437,6 +991,26 @@ void SimpleEQAudioProcessorEditor::resized()
     return;
 }
 
+bool SimpleEQAudioProcessorEditor::keyPressed(const juce::KeyPress& key) {
+    const auto command = juce::ModifierKeys::commandModifier;
+    if (key == juce::KeyPress('z', command, 0)) {
+        audioProcessor.undoChainSettings();
+        return true;
+    }
+    if (key == juce::KeyPress('z', command | juce::ModifierKeys::shiftModifier, 0) || key == juce::KeyPress('y', command, 0)) {
+        audioProcessor.redoChainSettings();
+        return true;
+    }
+    return false;
+}
+
+void SimpleEQAudioProcessorEditor::updateHistoryButtons() {
+    const auto& history = audioProcessor.getParameterHistory();
+    undoButton.setEnabled(history.canUndo());
+    redoButton.setEnabled(history.canRedo());
+    return;
+}
+
 std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComponents() {
     return {
         &peakFreqSlider,
@@ -446,6 +1020,22 @@ std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComponents() {
         &highCutFreqSlider,
         &lowCutSlopeSlider,
         &highCutSlopeSlider,
-        &responseCurve
+        &lowCutTypeBox,
+        &highCutTypeBox,
+        &responseCurve,
+        &phaseButton,
+        &groupDelayButton,
+        &autoGainButton,
+        &softClipButton,
+        &undoButton,
+        &redoButton,
+        &crossoverBandsBox,
+        &crossoverSlopeBox,
+        &crossoverFreq1Slider,
+        &crossoverFreq2Slider,
+        &crossoverFreq3Slider,
+        &inputMeterDisplay,
+        &outputMeterDisplay,
+        &matchStrip
     };
 }
@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "RefreshScheduler.h"
+#include "ResponseWorker.h"
 
 
 struct CustomRotarySlider : juce::Slider {
@@ -26,11 +28,15 @@ struct LookAndFeel : juce::LookAndFeel_V4 {
                            float rotarystartangle,
                            float rotaryendangle,
                            juce::Slider&) override;
+    
+    // Static part of the knob, RotarySliderWithLabels caches this as an image
+    void drawRotaryFace(juce::Graphics&, juce::Rectangle<float> bounds);
+    juce::Path createRotaryPointer(juce::Rectangle<float> bounds, float pointerInset);
 
 };
 
 struct RotarySliderWithLabels : juce::Slider {
-    RotarySliderWithLabels(juce::RangedAudioParameter& rap, const juce::String unitSuffix) :juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag, juce::Slider::TextEntryBoxPosition::NoTextBox), param(&rap), suffix(unitSuffix) {
+    RotarySliderWithLabels(juce::RangedAudioParameter& rap, const juce::String unitSuffix) :juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag, juce::Slider::TextEntryBoxPosition::NoTextBox), param(&rap), choiceParam(dynamic_cast<juce::AudioParameterChoice*>(&rap)), suffix(unitSuffix) {
         setLookAndFeel(&lnf);
     }
     ~RotarySliderWithLabels() {
@@ -44,6 +50,7 @@ struct RotarySliderWithLabels : juce::Slider {
     juce::Array<Labels> labels;
     
     void paint(juce::Graphics& g) override;
+    void resized() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
@@ -51,34 +58,194 @@ struct RotarySliderWithLabels : juce::Slider {
 private:
     LookAndFeel lnf;
     juce::RangedAudioParameter* param;
+    juce::AudioParameterChoice* choiceParam;
     juce::String suffix;
+    
+    // Jake: Knob face and dial labels don't depend on the value, so they are rendered once per
+    // size and display scale. Paint only blits them and adds the pointer and value text.
+    juce::Image faceCache;
+    float faceCacheScale = 0.0f;
+    juce::Path pointer;
+    double displayedValue = std::numeric_limits<double>::quiet_NaN();
+    juce::String displayText;
+    float displayTextWidth = 0.0f;
+    void renderFace(float scale);
+};
+
+// Jake: ComboBox listing the choices of a parameter, filled before its attachment is created
+struct ParameterComboBox : juce::ComboBox {
+    explicit ParameterComboBox(juce::RangedAudioParameter& rap) {
+        addItemList(rap.getAllValueStrings(), 1);
+    }
 };
 
 // Isolated response curve component
-struct ResponseCurve : juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer {
+struct ResponseCurve : juce::Component, juce::AudioProcessorParameter::Listener, RefreshClient, private juce::Timer {
     ResponseCurve(SimpleEQAudioProcessor&);
     ~ResponseCurve();
     
     void parameterValueChanged (int parameterIndex, float newValue) override;
-    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override {}
-    void timerCallback() override;
+    // Gestures are what the undo history coalesces on
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
+    
+    juce::Component& getRefreshComponent() override { return *this; }
+    void refresh() override;
     
     void paint (juce::Graphics&) override;
     void resized() override;
+    void visibilityChanged() override;
+    
+    // Handles: drag the peak for frequency and gain, a cut for its frequency. The wheel over a
+    // handle sets the peak's quality or the cut's slope.
+    void mouseMove(const juce::MouseEvent&) override;
+    void mouseExit(const juce::MouseEvent&) override;
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+    void mouseUp(const juce::MouseEvent&) override;
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+    
+    // Optional overlays, computed by the response worker
+    void setShowPhase(bool shouldShow);
+    void setShowGroupDelay(bool shouldShow);
 
 private:
     SimpleEQAudioProcessor& audioProcessor;
+    juce::SharedResourcePointer<RefreshScheduler> refreshScheduler;
     juce::Atomic<bool> parametersChanged {false};
     juce::Image background;
     
-    MonoChain monoChain;
-    void updateChain();
+    // Jake: Only drawn, so the coefficients are enough and no filter state is kept
+    ChainSettings chainSettings;
+    ChainCoefficients chainCoefficients;
+    void updateChain(const ChainSettings& newSettings);
+    
+    // Jake: The bands the curve is made of. Each band's magnitude on the column grid is cached
+    // and only evaluated again when that band's settings change, so moving one handle costs one
+    // band's sections per column. The trigonometry is done once per grid and sample rate.
+    enum Band {
+        Band_LowCut,
+        Band_Peak,
+        Band_HighCut,
+        NumBands,
+        Band_None = NumBands
+    };
+    std::array<std::vector<double>, NumBands> bandDecibels;
+    std::array<bool, NumBands> bandChanged {true, true, true};
+    MagnitudeEvaluator columnEvaluator;
+    double evaluatorSampleRate = 0.0;
+    ChainCoefficients getBandCoefficients(int band) const;
+    
+    // Jake: Handle interaction. A drag is one gesture per dragged parameter, wheel changes stay
+    // one gesture until the wheel has rested for wheelGestureMilliseconds.
+    static constexpr float handleRadius = 5.0f;
+    static constexpr int wheelGestureMilliseconds = 400;
+    int hoveredBand = Band_None;
+    int draggedBand = Band_None;
+    juce::RangedAudioParameter* wheelParameter = nullptr;
+    juce::Point<float> getHandlePosition(int band);
+    juce::Rectangle<float> getHandleBounds(int band);
+    juce::Rectangle<float> getAllHandleBounds();
+    int getBandAt(juce::Point<float> position);
+    std::vector<juce::RangedAudioParameter*> getDragParameters(int band) const;
+    void setParameterValue(juce::RangedAudioParameter& parameter, float value);
+    void setHoveredBand(int band);
+    void timerCallback() override;
+    
+    // Jake: One frequency per pixel column of the analysis area, shared by every curve
+    std::vector<double> columnFrequencies;
+    
+    // Jake: Phase and group delay come from the worker, paint only strokes the finished paths
+    ResponseWorker responseWorker;
+    bool showPhase = false;
+    bool showGroupDelay = false;
+    int drawnGeneration = 0;
+    juce::Path phasePath;
+    juce::Path groupDelayPath;
+    void requestOverlays(const ChainSettings& chainSettings);
+    void updateOverlayPaths();
+    
+    // Jake: Curve is rebuilt when the parameters change, paint only strokes it. Repaints are
+    // limited to the area covered by the old and new curve.
+    juce::Path responsePath;
+    std::vector<double> mags;
+    void updateResponsePath();
     juce::Rectangle<int> getRenderArea();
     juce::Rectangle<int> getAnalysisArea();
     int getTextHeight() const { return 12; }
     
 };
 
+// Jake: Peak/RMS bars and true-peak/loudness readouts of one LevelMeter. The meter only runs
+// while a display is attached to it. The display keeps the shared tick running only while its
+// values move or a peak is still falling back, then waits for the meter to report a change.
+struct LevelMeterDisplay : juce::Component, RefreshClient {
+    LevelMeterDisplay(LevelMeter& levelMeter, const juce::String& meterName);
+    ~LevelMeterDisplay();
+    
+    juce::Component& getRefreshComponent() override { return *this; }
+    void refresh() override;
+    bool wantsContinuousRefresh() const override { return isAnimating; }
+    
+    void paint(juce::Graphics&) override;
+    void visibilityChanged() override;
+    // Clears the true-peak hold and the clip count
+    void mouseDown(const juce::MouseEvent&) override;
+    
+    // Optional, shows the samples the clipper caught since the display was opened or clicked
+    void setSoftClipper(const SoftClipper* softClipper);
+    
+private:
+    LevelMeter& meter;
+    juce::String name;
+    juce::SharedResourcePointer<RefreshScheduler> refreshScheduler;
+    
+    // Peaks fall back at a fixed rate, true peak holds until clicked
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float peakFallbackDecibelsPerSecond = 20.0f;
+    std::array<float, LevelMeter::maxChannels> peakDecibels;
+    std::array<float, LevelMeter::maxChannels> rmsDecibels;
+    std::array<float, LevelMeter::maxChannels> truePeakHoldDecibels;
+    float momentaryLoudness = -100.0f;
+    float shortTermLoudness = -100.0f;
+    double lastRefreshTime = 0.0;
+    bool isAnimating = false;
+    
+    const SoftClipper* clipper = nullptr;
+    juce::uint64 clipCountAtReset = 0;
+    juce::uint64 clipCount = 0;
+};
+
+// Jake: Match-EQ controls. Learn runs the analyser on the input and the reference, which comes
+// from the sidechain or from a file, and Match fits the chain and writes it into the parameters.
+struct MatchStrip : juce::Component, RefreshClient {
+    explicit MatchStrip(SimpleEQAudioProcessor& processor);
+    ~MatchStrip();
+    
+    juce::Component& getRefreshComponent() override { return *this; }
+    void refresh() override;
+    // The learned seconds count up while learning or reading a file, plus one refresh after
+    bool wantsContinuousRefresh() const override;
+    
+    void resized() override;
+    
+private:
+    SimpleEQAudioProcessor& audioProcessor;
+    MatchAnalyser& analyser;
+    juce::SharedResourcePointer<RefreshScheduler> refreshScheduler;
+    bool wasBusy = false;
+    
+    juce::ToggleButton learnButton {"Learn"};
+    juce::ComboBox sourceBox;
+    juce::TextButton loadButton {"Reference..."};
+    juce::TextButton matchButton {"Match"};
+    juce::Label statusLabel;
+    juce::String lastResult;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    
+    void chooseFile();
+    void applyMatch();
+};
+
 //==============================================================================
 /**
 */
@@ -91,6 +258,8 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    // Cmd/Ctrl+Z undoes, with Shift (or Cmd/Ctrl+Y) redoes
+    bool keyPressed (const juce::KeyPress& key) override;
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -105,6 +274,26 @@ private:
     RotarySliderWithLabels highCutFreqSlider;
     RotarySliderWithLabels lowCutSlopeSlider;
     RotarySliderWithLabels highCutSlopeSlider;
+    ParameterComboBox lowCutTypeBox;
+    ParameterComboBox highCutTypeBox;
+    
+    // Jake: Overlay toggles drawn over the top right corner of the response curve
+    juce::ToggleButton phaseButton {"Phase"};
+    juce::ToggleButton groupDelayButton {"Delay"};
+    juce::ToggleButton autoGainButton {"Auto Gain"};
+    juce::ToggleButton softClipButton {"Soft Clip"};
+    
+    // Jake: Undo/redo of the chain settings, over the top left corner of the response curve
+    juce::TextButton undoButton {"Undo"};
+    juce::TextButton redoButton {"Redo"};
+    void updateHistoryButtons();
+    
+    // Jake: Crossover strip above the meters, bands go out on the "Band" buses
+    ParameterComboBox crossoverBandsBox;
+    ParameterComboBox crossoverSlopeBox;
+    juce::Slider crossoverFreq1Slider;
+    juce::Slider crossoverFreq2Slider;
+    juce::Slider crossoverFreq3Slider;
     
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachement = APVTS::SliderAttachment;
@@ -115,6 +304,19 @@ private:
     Attachement highCutFreqSliderAttachment;
     Attachement lowCutSlopeSliderAttachment;
     Attachement highCutSlopeSliderAttachment;
+    APVTS::ButtonAttachment autoGainButtonAttachment;
+    APVTS::ButtonAttachment softClipButtonAttachment;
+    APVTS::ComboBoxAttachment lowCutTypeBoxAttachment;
+    APVTS::ComboBoxAttachment highCutTypeBoxAttachment;
+    APVTS::ComboBoxAttachment crossoverBandsBoxAttachment;
+    APVTS::ComboBoxAttachment crossoverSlopeBoxAttachment;
+    Attachement crossoverFreq1SliderAttachment;
+    Attachement crossoverFreq2SliderAttachment;
+    Attachement crossoverFreq3SliderAttachment;
+    
+    LevelMeterDisplay inputMeterDisplay;
+    LevelMeterDisplay outputMeterDisplay;
+    MatchStrip matchStrip;
     
     std::vector<juce::Component*> getComponents();
     
@@ -16,12 +16,27 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                       .withOutput ("Band 1", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Band 2", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Band 3", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Band 4", juce::AudioChannelSet::stereo(), false)
                      #endif
                        )
 #endif
 {
+    outputGain.setRampDurationSeconds(autoGainRampSeconds);
+    
+    // One trace per instance, for sessions that only stutter inside a host
+    traceRecorder.watchParameters(getParameters());
+    const auto traceDirectory = juce::SystemStats::getEnvironmentVariable("SIMPLEEQ_TRACE_DIR", {});
+    if (traceDirectory.isNotEmpty()) {
+        const auto directory = juce::File::getCurrentWorkingDirectory().getChildFile(traceDirectory);
+        if (directory.createDirectory().wasOk())
+            traceRecorder.start(directory.getNonexistentChildFile("SimpleEQ-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S"), ".seqtrace", false));
+    }
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
@@ -96,24 +111,50 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
-    // Create ProcessSpec
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    // The chain filter has nothing to allocate, its state is cleared. Buffers only ever grow.
+    const auto blockSize = juce::jmax(samplesPerBlock, preparedBlockSize);
+    preparedBlockSize = blockSize;
+    chainFilter.reset();
+    inputMeter.prepare(sampleRate, blockSize, getMainBusNumInputChannels());
+    outputMeter.prepare(sampleRate, blockSize, getTotalNumOutputChannels());
+    loudnessEstimator.prepare(sampleRate);
+    outputGain.prepare({sampleRate, (juce::uint32)blockSize, (juce::uint32)getMainBusNumOutputChannels()});
+    crossover.setRampLength(sampleRate / automationGridSize, automationRampSeconds);
+    crossover.setSettings(crossoverParameters.load(), true);
+    crossover.prepare(sampleRate, blockSize);
+    softClipper.prepare(blockSize, getMainBusNumOutputChannels());
+    matchAnalyser.prepare(sampleRate, blockSize);
+    traceRecorder.prepare(sampleRate);
     
-    // Private MonoChain must be prepared using our spec
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // Start the automation grid from the current parameter values without ramping
+    targetSettings = chainParameters.load();
+    smoothedSettings.reset(sampleRate / automationGridSize, automationRampSeconds);
+    smoothedSettings.setCurrentAndTarget(targetSettings);
+    samplePosition = 0;
+    automationPending = false;
+    snapToTarget.set(false);
     
     // Create filters
-    updateFilters();
+    const auto coefficients = getDesignForRate(targetSettings, sampleRate);
+    applyCoefficients(coefficients);
+    
+    autoGainEnabled = autoGainParameter->load() > 0.5f;
+    outputGain.setGainLinear(getOutputGain(coefficients));
+    outputGain.reset();
+    outputGainSnapPending = false;
 }
 
 void SimpleEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    // Forget the prepared spec so the next prepareToPlay starts from scratch.
+    preparedBlockSize = 0;
+    inputMeter.release();
+    outputMeter.release();
+    crossover.release();
+    softClipper.release();
+    matchAnalyser.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -137,6 +178,20 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
         return false;
    #endif
 
+    // The sidechain is off, mono or stereo
+    for (int bus = 1; bus < layouts.inputBuses.size(); bus++) {
+        const auto& channels = layouts.inputBuses.getReference(bus);
+        if (!channels.isDisabled() && channels != juce::AudioChannelSet::mono() && channels != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
+    // Band outputs are either off or carry the same channels as the main output
+    for (int bus = 1; bus < layouts.outputBuses.size(); bus++) {
+        const auto& channels = layouts.outputBuses.getReference(bus);
+        if (!channels.isDisabled() && channels != layouts.getMainOutputChannelSet())
+            return false;
+    }
+
     return true;
   #endif
 }
@@ -145,8 +200,16 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
+    SIMPLEEQ_BLOCK_TIMER(stats);
+    ScopedTraceEvent traceBlock(traceRecorder, TraceEvent_Block, (juce::uint32)buffer.getNumSamples());
+    traceRecorder.beginBlock();
+    auto mainNumInputChannels   = getMainBusNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    
+    // The sidechain only feeds the match analyser. Its channels are shared with the band
+    // buses, so it is read before they are cleared.
+    if (getBusCount(true) > 1)
+        matchAnalyser.pushSidechain(getBusBuffer(buffer, true, 1));
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -154,7 +217,7 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     // This is here to avoid people getting screaming feedback
     // when they first compile a plugin, but obviously you don't need to keep
     // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+    for (auto i = mainNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
     // This is the place where you'd normally do the guts of your plugin's
@@ -170,17 +233,174 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
 //        // ..do something to the data...
 //    }
     
-    // Update filters before processing audio
-    updateFilters();
+    // The band buses were cleared above, everything else only touches the main bus
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    
+    {
+        SIMPLEEQ_STAGE_TIMER(stats, StageInputMeter);
+        inputMeter.process(mainBuffer);
+    }
+    matchAnalyser.pushInput(mainBuffer);
+    
+    // Pick up the latest parameter values, the host only changes them between blocks
+    auto chainSettings = chainParameters.load();
+    const auto snapped = snapToTarget.compareAndSetBool(false, true);
+    if (snapped) {
+        // State was replaced, jump straight to it instead of ramping
+        targetSettings = chainSettings;
+        smoothedSettings.setCurrentAndTarget(chainSettings);
+        automationPending = true;
+    }
+    else if (chainSettings != targetSettings) {
+        targetSettings = chainSettings;
+        smoothedSettings.setTarget(chainSettings);
+        automationPending = true;
+    }
+    
+    // The loudness estimate follows the target design. A new target gets it from the final step
+    // of its ramp below, switching auto gain alone uses the design already running.
+    const auto autoGain = autoGainParameter->load() > 0.5f;
+    outputGainSnapPending = outputGainSnapPending || snapped;
+    if (autoGain != autoGainEnabled) {
+        autoGainEnabled = autoGain;
+        if (!automationPending)
+            updateOutputGain();
+    }
+    
+    juce::dsp::AudioBlock<float> block(mainBuffer);
+    const auto numSamples = (int)block.getNumSamples();
+    
+    // No automation in flight, so the coefficients are current and the whole block can be processed
+    if (!automationPending) {
+        processChains(block);
+        samplePosition += numSamples;
+    }
+    else {
+        // Otherwise split the block on the automation grid and step the coefficients at each boundary
+        int offset = 0;
+        while (offset < numSamples) {
+            const auto gridOffset = (int)(samplePosition % automationGridSize);
+            if (gridOffset == 0) {
+                smoothedSettings.advance();
+                updateFilters(smoothedSettings.getCurrent());
+                automationPending = smoothedSettings.isSmoothing();
+                if (!automationPending)
+                    updateOutputGain();
+            }
+            
+            auto length = juce::jmin(numSamples - offset, automationGridSize - gridOffset);
+            if (!automationPending)
+                length = numSamples - offset;
+            
+            processChains(block.getSubBlock((size_t)offset, (size_t)length));
+            offset += length;
+            samplePosition += length;
+        }
+    }
+    
+    // One multiply per sample, skipped entirely at unity
+    if (outputGain.isSmoothing() || outputGain.getGainLinear() != 1.0f) {
+        juce::dsp::ProcessContextReplacing<float> context(block);
+        outputGain.process(context);
+    }
+    
+    const auto softClip = softClipParameter->load() > 0.5f;
+    if (softClip && !softClipEnabled)
+        softClipper.reset();
+    softClipEnabled = softClip;
+    if (softClipEnabled) {
+        SIMPLEEQ_STAGE_TIMER(stats, StageSoftClip);
+        softClipper.process(mainBuffer);
+    }
+    
+    {
+        SIMPLEEQ_STAGE_TIMER(stats, StageOutputMeter);
+        outputMeter.process(mainBuffer);
+    }
+    
+    // Nothing to split while every bus that would carry a band is disabled
+    crossover.setSettings(crossoverParameters.load(), snapped);
+    const auto numBandBuses = juce::jmin(crossover.getNumBands(), getBusCount(false) - 1);
+    auto bandBusEnabled = false;
+    for (int band = 0; band < numBandBuses; band++) {
+        bandBusEnabled = bandBusEnabled || getChannelCountOfBus(false, band + 1) > 0;
+    }
+    if (crossover.getNumBands() > 1 && bandBusEnabled) {
+        SIMPLEEQ_STAGE_TIMER(stats, StageCrossover);
+        processCrossover(buffer, samplePosition - numSamples);
+    }
+}
+
+
+void SimpleEQAudioProcessor::processCrossover(juce::AudioBuffer<float>& buffer, juce::int64 blockPosition) {
+    // The splitter holds one prepared block of bands, hosts may send more than they announced
+    if (preparedBlockSize <= 0)
+        return;
+    
+    const auto mainBuffer = getBusBuffer(buffer, false, 0);
+    const auto numSamples = buffer.getNumSamples();
+    const auto numBandBuses = juce::jmin(crossover.getNumBands(), getBusCount(false) - 1);
     
-    // Process AudioBlock for Left and Right Channel
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    // Frequency ramps step on the same grid as the chain's, whole chunks go through otherwise
+    for (int start = 0; start < numSamples;) {
+        auto length = juce::jmin(preparedBlockSize, numSamples - start);
+        if (crossover.isSmoothing()) {
+            const auto gridOffset = (int)((blockPosition + start) % automationGridSize);
+            if (gridOffset == 0)
+                crossover.advance();
+            if (crossover.isSmoothing())
+                length = juce::jmin(length, automationGridSize - gridOffset);
+        }
+        crossover.process(juce::dsp::AudioBlock<const float>(mainBuffer).getSubBlock((size_t)start, (size_t)length));
+        
+        for (int band = 0; band < numBandBuses; band++) {
+            auto busBuffer = getBusBuffer(buffer, false, band + 1);
+            juce::dsp::AudioBlock<float>(busBuffer).getSubBlock((size_t)start, (size_t)length).copyFrom(crossover.getBand(band));
+        }
+        start += length;
+    }
+    return;
+}
+
+void SimpleEQAudioProcessor::processChains(const juce::dsp::AudioBlock<float>& block) {
+    const auto numChannels = juce::jmin((int)block.getNumChannels(), ChainFilter::maxChannels);
+    const auto numSamples = (int)block.getNumSamples();
+    std::array<float*, ChainFilter::maxChannels> channels {};
+    for (int ch = 0; ch < numChannels; ch++) {
+        channels[(size_t)ch] = block.getChannelPointer((size_t)ch);
+    }
+    
+  #if SIMPLEEQ_INSTRUMENTATION
+    // The kernels run all stages sample by sample, so instrumented builds go one stage at a time
+    // to time each of them. A peak ringing out already runs that way and is counted as the peak.
+    if (chainFilter.isPeakRingingOut()) {
+        SIMPLEEQ_STAGE_TIMER(stats, StagePeak);
+        chainFilter.process(channels.data(), numChannels, numSamples);
+        return;
+    }
+    {
+        SIMPLEEQ_STAGE_TIMER(stats, StageLowCut);
+        for (int ch = 0; ch < numChannels; ch++) {
+            chainFilter.processLowCut(ch, channels[(size_t)ch], numSamples);
+        }
+    }
+    if (chainFilter.isPeakActive()) {
+        SIMPLEEQ_STAGE_TIMER(stats, StagePeak);
+        for (int ch = 0; ch < numChannels; ch++) {
+            chainFilter.processPeak(ch, channels[(size_t)ch], numSamples);
+        }
+    }
+    {
+        SIMPLEEQ_STAGE_TIMER(stats, StageHighCut);
+        for (int ch = 0; ch < numChannels; ch++) {
+            chainFilter.processHighCut(ch, channels[(size_t)ch], numSamples);
+        }
+    }
+  #else
+    // Mono or stereo, the kernel for the layout and the current design is picked once per block
+    chainFilter.process(channels.data(), numChannels, numSamples);
+  #endif
+    return;
 }
 
 //==============================================================================
@@ -202,7 +422,9 @@ void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
     juce::MemoryOutputStream mos(destData, true);
-    aptvs.state.writeToStream(mos);
+    auto state = aptvs.copyState();
+    state.setProperty(stateVersionProperty, currentStateVersion, nullptr);
+    state.writeToStream(mos);
     return;
 }
 
@@ -212,88 +434,258 @@ void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBy
     // whose contents will have been created by the getStateInformation() call.
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid()) {
+        upgradeState(tree);
         aptvs.replaceState(tree);
-        updateFilters();
+        // Let the audio thread jump to the loaded settings on its next block
+        snapToTarget.set(true);
     }
     return;
 }
 
 //== Jake ======================================================================
 
+std::optional<MatchFit> SimpleEQAudioProcessor::applyMatch() {
+    jassert(juce::MessageManager::existsAndIsCurrentThread());
+    const auto fit = matchAnalyser.match(getChainSettings(aptvs), getSampleRate() > 0.0 ? getSampleRate() : 48000.0);
+    if (!fit.has_value())
+        return fit;
+    
+    setChainSettings(fit->settings);
+    return fit;
+}
+
+
+void SimpleEQAudioProcessor::chainGestureChanged(bool gestureIsStarting) {
+    if (restoringHistory)
+        return;
+    
+    const auto settings = chainParameters.load();
+    if (gestureIsStarting)
+        parameterHistory.beginGesture(settings);
+    else
+        parameterHistory.endGesture(settings);
+    return;
+}
+
+
+bool SimpleEQAudioProcessor::undoChainSettings() {
+    const auto settings = parameterHistory.undo(chainParameters.load());
+    if (!settings.has_value())
+        return false;
+    
+    const juce::ScopedValueSetter<bool> restoring(restoringHistory, true);
+    setChainSettings(*settings);
+    return true;
+}
+
+
+bool SimpleEQAudioProcessor::redoChainSettings() {
+    const auto settings = parameterHistory.redo(chainParameters.load());
+    if (!settings.has_value())
+        return false;
+    
+    const juce::ScopedValueSetter<bool> restoring(restoringHistory, true);
+    setChainSettings(*settings);
+    return true;
+}
+
+
+void SimpleEQAudioProcessor::setChainSettings(const ChainSettings& settings) {
+    const std::array<std::pair<const char*, float>, 9> values {{
+        {"Low-Cut Freq", settings.lowCutFreq},
+        {"High-Cut Freq", settings.highCutFreq},
+        {"Peak Freq", settings.peakFreq},
+        {"Peak Gain", settings.peakGainInDecibels},
+        {"Peak Quality", settings.peakQuality},
+        {"Low-Cut Slope", (float)settings.lowCutSlope},
+        {"High-Cut Slope", (float)settings.highCutSlope},
+        {"Low-Cut Type", (float)settings.lowCutType},
+        {"High-Cut Type", (float)settings.highCutType},
+    }};
+    
+    // The gestures below nest inside this one, so the history gets a single entry
+    chainGestureChanged(true);
+    for (const auto& [id, value] : values) {
+        auto* parameter = aptvs.getParameter(id);
+        const auto normalised = parameter->convertTo0to1(value);
+        if (normalised == parameter->getValue())
+            continue;
+        
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(normalised);
+        parameter->endChangeGesture();
+    }
+    chainGestureChanged(false);
+    return;
+}
+
+
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
     /* Extract settings from given parameters */
+    return ChainParameters(apvts).load();
+}
+
+
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apvts)
+    : lowCutFreq(apvts.getRawParameterValue("Low-Cut Freq")),
+      highCutFreq(apvts.getRawParameterValue("High-Cut Freq")),
+      peakFreq(apvts.getRawParameterValue("Peak Freq")),
+      peakGain(apvts.getRawParameterValue("Peak Gain")),
+      peakQuality(apvts.getRawParameterValue("Peak Quality")),
+      lowCutSlope(apvts.getRawParameterValue("Low-Cut Slope")),
+      highCutSlope(apvts.getRawParameterValue("High-Cut Slope")),
+      lowCutType(apvts.getRawParameterValue("Low-Cut Type")),
+      highCutType(apvts.getRawParameterValue("High-Cut Type")) {
+}
+
+
+CrossoverParameters::CrossoverParameters(juce::AudioProcessorValueTreeState& apvts)
+    : bands(apvts.getRawParameterValue("Crossover Bands")),
+      frequencies {apvts.getRawParameterValue("Crossover Freq 1"),
+                   apvts.getRawParameterValue("Crossover Freq 2"),
+                   apvts.getRawParameterValue("Crossover Freq 3")},
+      slope(apvts.getRawParameterValue("Crossover Slope")) {
+}
+
+
+CrossoverSettings CrossoverParameters::load() const {
+    CrossoverSettings settings;
+    
+    // Choice index 0 is "Off", a single band
+    settings.numBands = 1 + (int)bands->load();
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        settings.frequencies[i] = frequencies[i]->load();
+    }
+    settings.slope = static_cast<CrossoverSlope>(slope->load());
+    
+    return settings;
+}
+
+
+ChainSettings ChainParameters::load() const {
     ChainSettings settings;
     
     // Load defined parameters
-    settings.lowCutFreq = apvts.getRawParameterValue("Low-Cut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("High-Cut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("Low-Cut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("High-Cut Slope")->load());
+    settings.lowCutFreq = lowCutFreq->load();
+    settings.highCutFreq = highCutFreq->load();
+    settings.peakFreq = peakFreq->load();
+    settings.peakGainInDecibels = peakGain->load();
+    settings.peakQuality = peakQuality->load();
+    settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load());
+    settings.highCutSlope = static_cast<Slope>(highCutSlope->load());
+    settings.lowCutType = static_cast<CutType>(lowCutType->load());
+    settings.highCutType = static_cast<CutType>(highCutType->load());
     
     return settings;
 }
 
 
-void updateCoefficents(Coefficients& old, const Coefficients& replacement) {
-    *old = *replacement;
+void SmoothedChainSettings::reset(double stepsPerSecond, double rampLengthInSeconds) {
+    peakFreq.reset(stepsPerSecond, rampLengthInSeconds);
+    lowCutFreq.reset(stepsPerSecond, rampLengthInSeconds);
+    highCutFreq.reset(stepsPerSecond, rampLengthInSeconds);
+    peakGainInDecibels.reset(stepsPerSecond, rampLengthInSeconds);
+    peakQuality.reset(stepsPerSecond, rampLengthInSeconds);
     return;
 }
 
 
-void SimpleEQAudioProcessor::updateFilters() {
-    auto chainSettings = getChainSettings(aptvs);
-    updatePeakFilter(chainSettings);
-    updateLowCutFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
+void SmoothedChainSettings::setCurrentAndTarget(const ChainSettings& chainSettings) {
+    target = chainSettings;
+    peakFreq.setCurrentAndTargetValue(chainSettings.peakFreq);
+    lowCutFreq.setCurrentAndTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(chainSettings.highCutFreq);
+    peakGainInDecibels.setCurrentAndTargetValue(chainSettings.peakGainInDecibels);
+    peakQuality.setCurrentAndTargetValue(chainSettings.peakQuality);
     return;
 }
 
 
-CoefficientArray makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate,  2 * (chainSettings.lowCutSlope) + 1);
-    return lowCutCoefficients;
+void SmoothedChainSettings::setTarget(const ChainSettings& chainSettings) {
+    target = chainSettings;
+    peakFreq.setTargetValue(chainSettings.peakFreq);
+    lowCutFreq.setTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setTargetValue(chainSettings.highCutFreq);
+    peakGainInDecibels.setTargetValue(chainSettings.peakGainInDecibels);
+    peakQuality.setTargetValue(chainSettings.peakQuality);
+    return;
 }
 
 
-void SimpleEQAudioProcessor::updateLowCutFilter(const ChainSettings &chainSettings) {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+void SmoothedChainSettings::advance() {
+    peakFreq.getNextValue();
+    lowCutFreq.getNextValue();
+    highCutFreq.getNextValue();
+    peakGainInDecibels.getNextValue();
+    peakQuality.getNextValue();
     return;
 }
 
 
-CoefficientArray makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
-    return highCutCoefficients;
+bool SmoothedChainSettings::isSmoothing() const {
+    return peakFreq.isSmoothing() || lowCutFreq.isSmoothing() || highCutFreq.isSmoothing()
+        || peakGainInDecibels.isSmoothing() || peakQuality.isSmoothing();
 }
 
 
-void SimpleEQAudioProcessor::updateHighCutFilter(const ChainSettings &chainSettings) {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+ChainSettings SmoothedChainSettings::getCurrent() const {
+    // Slopes are discrete so they switch as soon as the target is picked up
+    auto settings = target;
+    settings.peakFreq = peakFreq.getCurrentValue();
+    settings.lowCutFreq = lowCutFreq.getCurrentValue();
+    settings.highCutFreq = highCutFreq.getCurrentValue();
+    settings.peakGainInDecibels = peakGainInDecibels.getCurrentValue();
+    settings.peakQuality = peakQuality.getCurrentValue();
+    return settings;
+}
+
+
+void SimpleEQAudioProcessor::updateFilters(const ChainSettings& chainSettings) {
+    SIMPLEEQ_STAGE_TIMER(stats, StageCoefficients);
+    SIMPLEEQ_COUNT_REBUILD(stats);
+    ScopedTraceEvent traceRebuild(traceRecorder, TraceEvent_CoefficientRebuild);
+    applyCoefficients(makeChainCoefficients(chainSettings, getSampleRate()));
+    return;
+}
+
+
+void SimpleEQAudioProcessor::applyCoefficients(const ChainCoefficients& coefficients) {
+    chainFilter.setCoefficients(coefficients);
+    appliedCoefficients = coefficients;
     return;
 }
 
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate) {
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
-    return peakCoefficients;
+ChainCoefficients SimpleEQAudioProcessor::getDesignForRate(const ChainSettings& chainSettings, double sampleRate) {
+    for (const auto& design : rateDesigns) {
+        if (design.isValid && design.sampleRate == sampleRate && design.settings == chainSettings)
+            return design.coefficients;
+    }
+    
+    // Only the requested rate is designed, it replaces the oldest entry
+    auto& design = rateDesigns[nextRateDesign];
+    nextRateDesign = (nextRateDesign + 1) % rateDesigns.size();
+    design.sampleRate = sampleRate;
+    design.settings = chainSettings;
+    design.coefficients = makeChainCoefficients(chainSettings, sampleRate);
+    design.isValid = true;
+    return design.coefficients;
+}
+
+
+float SimpleEQAudioProcessor::getOutputGain(const ChainCoefficients& coefficients) const {
+    return autoGainEnabled ? loudnessEstimator.getCompensationGain(coefficients) : 1.0f;
 }
 
 
-void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings) {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    updateCoefficents(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficents(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+void SimpleEQAudioProcessor::updateOutputGain() {
+    SIMPLEEQ_STAGE_TIMER(stats, StageCoefficients);
+    outputGain.setGainLinear(getOutputGain(appliedCoefficients));
+    
+    // A replaced state jumps to its gain like it jumps to its design
+    if (outputGainSnapPending)
+        outputGain.reset();
+    outputGainSnapPending = false;
     return;
 }
 
@@ -308,14 +700,27 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"Peak Gain", 1}, "Peak Gain", juce::NormalisableRange<float>(-24.0, 24.0, 0.5, 1.0), 0.0));
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"Peak Quality", 1}, "Peak Quality", juce::NormalisableRange<float>(0.1, 10.0, 0.05, 1.0), 1.0));
     juce::StringArray choiceArray;
-    for(int i = 0; i < 4; i++) {
+    for(int i = 0; i < NumSlopes; i++) {
         juce::String str;
-        str << (12 + i*12);
+        str << (6 + i*6);
         str << " db/Oct";
         choiceArray.add(str);
     }
-    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"Low-Cut Slope", 1}, "Low-Cut Slope", choiceArray, 0.0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"High-Cut Slope", 1}, "High-Cut Slope", choiceArray, 0.0));
+    // Version 2 of the layout went from four slopes to sixteen and added the cut types, their IDs
+    // carry that version so hosts see the parameters changed. Saved states are converted by
+    // upgradeState().
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"Low-Cut Slope", 2}, "Low-Cut Slope", choiceArray, Slope_12));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"High-Cut Slope", 2}, "High-Cut Slope", choiceArray, Slope_12));
+    juce::StringArray typeArray {"Butterworth", "Linkwitz-Riley", "Bessel", "Chebyshev"};
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"Low-Cut Type", 2}, "Low-Cut Type", typeArray, CutType_Butterworth));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"High-Cut Type", 2}, "High-Cut Type", typeArray, CutType_Butterworth));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"Auto Gain", 1}, "Auto Gain", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"Soft Clip", 1}, "Soft Clip", false));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"Crossover Bands", 1}, "Crossover Bands", juce::StringArray {"Off", "2 Bands", "3 Bands", "4 Bands"}, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"Crossover Freq 1", 1}, "Crossover Freq 1", juce::NormalisableRange<float>(20.0, 20000.0, 1.0, 0.4), 200.0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"Crossover Freq 2", 1}, "Crossover Freq 2", juce::NormalisableRange<float>(20.0, 20000.0, 1.0, 0.4), 2000.0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"Crossover Freq 3", 1}, "Crossover Freq 3", juce::NormalisableRange<float>(20.0, 20000.0, 1.0, 0.4), 8000.0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"Crossover Slope", 1}, "Crossover Slope", juce::StringArray {"12 db/Oct", "24 db/Oct", "48 db/Oct", "96 db/Oct"}, CrossoverSlope_24));
     
     return layout;
 }
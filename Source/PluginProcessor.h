@@ -12,206 +12,69 @@
 
 #include <array>
 
+#include "ChainFilter.h"
+#include "Crossover.h"
+#include "EQDesign.h"
+#include "Instrumentation.h"
+#include "LevelMeter.h"
+#include "MatchEQ.h"
+#include "ParameterHistory.h"
+#include "ResponseAnalysis.h"
+#include "SampleFifo.h"
+#include "SoftClipper.h"
+#include "TraceRecorder.h"
 
-enum Channel {
-    Right,
-    Left
-};
 
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
-template<typename T>
-struct Fifo
-{
-    void prepare(int numChannels, int numSamples)
-    {
-        static_assert( std::is_same_v<T, juce::AudioBuffer<float>>,
-                      "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
-        for( auto& buffer : buffers)
-        {
-            buffer.setSize(numChannels,
-                           numSamples,
-                           false,   //clear everything?
-                           true,    //including the extra space?
-                           true);   //avoid reallocating if you can?
-            buffer.clear();
-        }
-    }
-    
-    void prepare(size_t numElements)
-    {
-        static_assert( std::is_same_v<T, std::vector<float>>,
-                      "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
-        for( auto& buffer : buffers )
-        {
-            buffer.clear();
-            buffer.resize(numElements, 0);
-        }
-    }
-    
-    bool push(const T& t)
-    {
-        auto write = fifo.write(1);
-        if( write.blockSize1 > 0 )
-        {
-            buffers[write.startIndex1] = t;
-            return true;
-        }
-        
-        return false;
-    }
-    
-    bool pull(T& t)
-    {
-        auto read = fifo.read(1);
-        if( read.blockSize1 > 0 )
-        {
-            t = buffers[read.startIndex1];
-            return true;
-        }
-        
-        return false;
-    }
+
+// Jake: Raw parameter values looked up once by ID, so the audio thread can read the
+// settings without building Strings or searching the parameter map every block.
+struct ChainParameters {
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& apvts);
+    ChainSettings load() const;
     
-    int getNumAvailableForReading() const
-    {
-        return fifo.getNumReady();
-    }
 private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo {Capacity};
+    std::atomic<float>* lowCutFreq;
+    std::atomic<float>* highCutFreq;
+    std::atomic<float>* peakFreq;
+    std::atomic<float>* peakGain;
+    std::atomic<float>* peakQuality;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* lowCutType;
+    std::atomic<float>* highCutType;
 };
 
 
-template<typename BlockType>
-struct SingleChannelSampleFifo
-{
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
-    {
-        prepared.set(false);
-    }
+// Jake: Raw crossover parameter values, looked up once like ChainParameters
+struct CrossoverParameters {
+    explicit CrossoverParameters(juce::AudioProcessorValueTreeState& apvts);
+    CrossoverSettings load() const;
     
-    void update(const BlockType& buffer)
-    {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse );
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
-        
-        for( int i = 0; i < buffer.getNumSamples(); ++i )
-        {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
-    }
-
-    void prepare(int bufferSize)
-    {
-        prepared.set(false);
-        size.set(bufferSize);
-        
-        bufferToFill.setSize(1,             //channel
-                             bufferSize,    //num samples
-                             false,         //keepExistingContent
-                             true,          //clear extra space
-                             true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
-    }
-    //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
-    //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
 private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
-    
-    void pushNextSampleIntoFifo(float sample)
-    {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
-            
-            fifoIndex = 0;
-        }
-        
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
-    }
-};
-
-
-// Jake: Enum representing slope order
-enum Slope {
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
+    std::atomic<float>* bands;
+    std::array<std::atomic<float>*, CrossoverSettings::maxBands - 1> frequencies;
+    std::atomic<float>* slope;
 };
 
-// Jake: Names of filters and chains used in project.
-using Filter = juce::dsp::IIR::Filter<float>;
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-using Coefficients = Filter::CoefficientsPtr;
-using CoefficientArray = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
 
-
-// Jake: Enum representing positions of filters in chain.
-enum ChainPositions {
-    LowCut,
-    Peak,
-    HighCut
-};
-
-
-// Jake: Struct for extracting settings from our parameters
-struct ChainSettings {
-    float peakFreq = 0;
-    float peakGainInDecibels = 0;
-    float peakQuality = 0;
-    float lowCutFreq = 0;
-    float highCutFreq = 0;
-    Slope lowCutSlope = Slope::Slope_12;
-    Slope highCutSlope = Slope::Slope_12;
+// Jake: Smoothed copy of ChainSettings. One step of the smoothers is one automation grid cell,
+// so the ramp only depends on absolute sample position and not on the host's buffer size.
+struct SmoothedChainSettings {
+    void reset(double stepsPerSecond, double rampLengthInSeconds);
+    void setCurrentAndTarget(const ChainSettings& chainSettings);
+    void setTarget(const ChainSettings& chainSettings);
+    void advance();
+    bool isSmoothing() const;
+    ChainSettings getCurrent() const;
+    
+private:
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> peakFreq, lowCutFreq, highCutFreq;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> peakGainInDecibels, peakQuality;
+    ChainSettings target;
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-CoefficientArray makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate);
-CoefficientArray makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate);
-void updateCoefficents(Coefficients& old, const Coefficients& replacement);
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& cutChain, const CoefficientType cutCoefficients, const Slope& cutSlope) {
-    cutChain.template setBypassed<0>(true);
-    cutChain.template setBypassed<1>(true);
-    cutChain.template setBypassed<2>(true);
-    cutChain.template setBypassed<3>(true);
-    switch (cutSlope) {
-        case Slope_48:
-            updateCoefficents(cutChain.template get<3>().coefficients, cutCoefficients[3]);
-            cutChain.template setBypassed<3>(false);
-        case Slope_36:
-            updateCoefficents(cutChain.template get<2>().coefficients, cutCoefficients[2]);
-            cutChain.template setBypassed<2>(false);
-        case Slope_24:
-            updateCoefficents(cutChain.template get<1>().coefficients, cutCoefficients[1]);
-            cutChain.template setBypassed<1>(false);
-        case Slope_12:
-            updateCoefficents(cutChain.template get<0>().coefficients, cutCoefficients[0]);
-            cutChain.template setBypassed<0>(false);
-            break;
-    }
-}
-    
 
 
 //==============================================================================
@@ -264,17 +127,115 @@ public:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState aptvs{*this, nullptr, "Parameters", createParameterLayout()};
     
+    // Jake: Audio thread timings, only filled in when built with SIMPLEEQ_INSTRUMENTATION
+    ProcessorStats& getStats() { return stats; }
+    
+    // Jake: Optional trace of blocks, rebuilds and parameter changes for offline profiling. Started
+    // by the host tools, or for every instance when SIMPLEEQ_TRACE_DIR names a directory.
+    TraceRecorder& getTraceRecorder() { return traceRecorder; }
+    
+    // Jake: Level and loudness of the bus before and after the EQ, idle until enabled by the editor
+    LevelMeter& getInputMeter() { return inputMeter; }
+    LevelMeter& getOutputMeter() { return outputMeter; }
+    
+    // Jake: Output safety stage, the editor shows its clip count
+    const SoftClipper& getSoftClipper() const { return softClipper; }
+    
+    // Jake: Learns the input and reference spectra for Match-EQ
+    MatchAnalyser& getMatchAnalyser() { return matchAnalyser; }
+    
+    // Jake: Message thread. Fits the chain to what the analyser has learned and writes the result
+    // into the parameters, one gesture each, so hosts record it and the audio thread ramps to it.
+    std::optional<MatchFit> applyMatch();
+    
+    // Jake: Undo/redo of the chain settings, message thread only. The editor reports gestures,
+    // undo and redo set the parameters that differ from the restored snapshot.
+    const ParameterHistory& getParameterHistory() const { return parameterHistory; }
+    void setHistoryListener(std::function<void()> listener) { parameterHistory.onChange = std::move(listener); }
+    void chainGestureChanged(bool gestureIsStarting);
+    bool undoChainSettings();
+    bool redoChainSettings();
+    
 private:
     //== Setting Aliases ===========================================================
     
-    //NOTE: Processor chains allows running of 4 filters in a single chain call
-    MonoChain leftChain;
-    MonoChain rightChain;
+    // Jake: Coefficients and state of both channels, shared coefficients in one aligned block
+    ChainFilter chainFilter;
+    
+    // Jake: Automation is applied on a fixed grid of absolute sample positions. Coefficients are
+    // only redesigned at grid boundaries while a parameter ramp is in flight, otherwise whole
+    // blocks go straight through the chains.
+    static constexpr int automationGridSize = 32;
+    static constexpr double automationRampSeconds = 0.01;
+    ChainParameters chainParameters {aptvs};
+    ChainSettings targetSettings;
+    SmoothedChainSettings smoothedSettings;
+    juce::int64 samplePosition = 0;
+    bool automationPending = false;
+    juce::Atomic<bool> snapToTarget {false};
+    
+    ProcessorStats stats;
+    TraceRecorder traceRecorder;
+    LevelMeter inputMeter;
+    LevelMeter outputMeter;
+    
+    // Jake: Output gain undoing the loudness change of the EQ. It is estimated from the design of
+    // the final grid step of a ramp, which is the target's, never from the audio, and ramped in
+    // by juce::dsp::Gain. The coefficients the chain runs are kept so nothing is designed twice.
+    static constexpr double autoGainRampSeconds = 0.05;
+    std::atomic<float>* autoGainParameter = aptvs.getRawParameterValue("Auto Gain");
+    bool autoGainEnabled = false;
+    bool outputGainSnapPending = false;
+    LoudnessEstimator loudnessEstimator;
+    juce::dsp::Gain<float> outputGain;
+    ChainCoefficients appliedCoefficients;
+    float getOutputGain(const ChainCoefficients& coefficients) const;
+    void updateOutputGain();
+    
+    // Jake: Soft clips the main output after the gain stage when "Soft Clip" is on, so boosts
+    // can't push the bus past 0 dBFS. No lookahead, the clipper starts over when switched on.
+    std::atomic<float>* softClipParameter = aptvs.getRawParameterValue("Soft Clip");
+    bool softClipEnabled = false;
+    SoftClipper softClipper;
+    
+    // Jake: Fed with the main input before the EQ and with the optional "Sidechain" bus
+    MatchAnalyser matchAnalyser;
+    
+    // Jake: Written on the message thread only. Restoring sets parameters with gestures of its
+    // own, which must not be recorded as new steps.
+    ParameterHistory parameterHistory;
+    bool restoringHistory = false;
+    
+    // Jake: Sets every chain parameter that differs from settings, each as one host gesture, and
+    // records the lot as one history entry unless a snapshot is being restored
+    void setChainSettings(const ChainSettings& settings);
+    
+    // Jake: Splits the output into the "Band" buses when crossover mode is on. The main output
+    // keeps the full EQ'd signal, buses past the selected band count stay silent. Split
+    // frequencies ramp on the automation grid, blockPosition is where the block started on it.
+    CrossoverParameters crossoverParameters {aptvs};
+    Crossover crossover;
+    void processCrossover(juce::AudioBuffer<float>& buffer, juce::int64 blockPosition);
+    
+    // Jake: The largest block the processor was prepared for, buffers never shrink.
+    int preparedBlockSize = 0;
+    
+    // Jake: The last few designs prepareToPlay asked for, each made only when first requested.
+    // Switching back to a rate with unchanged settings (session reload, offline bounce) only
+    // copies coefficients, changed settings miss and replace the oldest entry.
+    struct RateDesign {
+        double sampleRate = 0.0;
+        bool isValid = false;
+        ChainSettings settings;
+        ChainCoefficients coefficients;
+    };
+    std::array<RateDesign, 4> rateDesigns;
+    size_t nextRateDesign = 0;
+    ChainCoefficients getDesignForRate(const ChainSettings& chainSettings, double sampleRate);
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilter(const ChainSettings& chainSettings);
-    void updateHighCutFilter(const ChainSettings& chainSettings);
-    void updateFilters();
+    void applyCoefficients(const ChainCoefficients& coefficients);
+    void updateFilters(const ChainSettings& chainSettings);
+    void processChains(const juce::dsp::AudioBlock<float>& block);
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    RefreshScheduler.cpp
+    One repaint tick shared by every SimpleEQ editor in the process.
+
+  ==============================================================================
+*/
+
+#include "RefreshScheduler.h"
+
+RefreshScheduler::~RefreshScheduler() {
+    cancelPendingUpdate();
+    vBlank.reset();
+}
+
+void RefreshScheduler::addClient(RefreshClient& client) {
+    JUCE_ASSERT_MESSAGE_THREAD
+    clients.addIfNotAlreadyThere(&client);
+    if (client.refreshPending.load())
+        requestRefresh(client);
+    return;
+}
+
+void RefreshScheduler::removeClient(RefreshClient& client) {
+    JUCE_ASSERT_MESSAGE_THREAD
+    clients.removeFirstMatchingValue(&client);
+    if (vBlankComponent == &client.getRefreshComponent()) {
+        // The tick was attached to this client's component, move it to another one
+        detach();
+        if (isAwake.load() && !attachToShowingClient())
+            isAwake.store(false);
+    }
+    return;
+}
+
+void RefreshScheduler::requestRefresh(RefreshClient& client) {
+    client.refreshPending.store(true);
+    
+    if (!juce::MessageManager::existsAndIsCurrentThread()) {
+        // A running tick picks the flag up by itself. Otherwise only the first request posts,
+        // the rest ride on the same message until handleAsyncUpdate clears wakeRequested.
+        if (!isAwake.load() && !wakeRequested.exchange(true))
+            triggerAsyncUpdate();
+        return;
+    }
+    
+    // Only the first request after going idle needs to wake the scheduler
+    if (!isAwake.exchange(true))
+        wake();
+    return;
+}
+
+void RefreshScheduler::handleAsyncUpdate() {
+    // A wake up from another thread, or the tick went idle and asked to be detached. Clear the
+    // flag first so a request arriving from here on posts again.
+    wakeRequested.store(false);
+    if (isAwake.load()) {
+        wake();
+    }
+    else {
+        detach();
+        // A request may have arrived between going idle and detaching
+        if (hasPendingWork() && !isAwake.exchange(true))
+            wake();
+    }
+    return;
+}
+
+void RefreshScheduler::wake() {
+    if (vBlankComponent != nullptr && !vBlankComponent->isShowing())
+        detach();
+    
+    if (vBlank == nullptr && !attachToShowingClient()) {
+        // Nothing is on screen, clients ask again when they become visible
+        isAwake.store(false);
+    }
+    return;
+}
+
+void RefreshScheduler::detach() {
+    vBlank.reset();
+    vBlankComponent = nullptr;
+    return;
+}
+
+bool RefreshScheduler::attachToShowingClient() {
+    for (auto* client : clients) {
+        auto& component = client->getRefreshComponent();
+        if (component.isShowing()) {
+            vBlankComponent = &component;
+            vBlank = std::make_unique<juce::VBlankAttachment>(&component, [this] { tick(); });
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RefreshScheduler::hasPendingWork() const {
+    for (auto* client : clients) {
+        if (!client->getRefreshComponent().isShowing())
+            continue;
+        if (client->refreshPending.load() || client->wantsContinuousRefresh())
+            return true;
+    }
+    return false;
+}
+
+void RefreshScheduler::tick() {
+    if (!isAwake.load())
+        return;
+    
+    for (auto* client : clients) {
+        // Hidden or minimised editors keep their pending flag until they are shown again
+        if (!client->getRefreshComponent().isShowing())
+            continue;
+        
+        if (client->refreshPending.exchange(false) || client->wantsContinuousRefresh())
+            client->refresh();
+    }
+    
+    if (!hasPendingWork() || !vBlankComponent->isShowing()) {
+        // Go idle, or follow another visible client. The attachment can't be destroyed from
+        // inside its own callback, so that happens on the next message loop iteration.
+        isAwake.store(false);
+        triggerAsyncUpdate();
+    }
+    return;
+}
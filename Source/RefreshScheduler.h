@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    RefreshScheduler.h
+    One repaint tick shared by every SimpleEQ editor in the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+
+
+// Jake: A component that wants to be refreshed by the RefreshScheduler
+struct RefreshClient {
+    virtual ~RefreshClient() = default;
+    
+    virtual juce::Component& getRefreshComponent() = 0;
+    // Called on the message thread from the shared tick
+    virtual void refresh() = 0;
+    // Clients that animate on their own (e.g. analyzers) keep the tick running while showing
+    virtual bool wantsContinuousRefresh() const { return false; }
+    
+private:
+    friend class RefreshScheduler;
+    std::atomic<bool> refreshPending {false};
+};
+
+
+// Jake: Coalesces repaints from all clients into a single tick aligned to the display's
+// vertical blank. Clients that aren't showing are skipped and keep their pending refresh
+// until they are shown again, and the tick stops entirely when nothing is pending.
+// Requests from other threads post at most one wake up message until the message thread has
+// served it, and none at all while the tick is running.
+// Hold it through a juce::SharedResourcePointer so every editor shares one instance.
+class RefreshScheduler : private juce::AsyncUpdater {
+public:
+    RefreshScheduler() = default;
+    ~RefreshScheduler() override;
+    
+    // Message thread only
+    void addClient(RefreshClient& client);
+    void removeClient(RefreshClient& client);
+    
+    // Any thread. Off the message thread it stores the flags and, only if the scheduler is idle
+    // and no wake up is on its way yet, triggers an async update. That's the same cost JUCE's own
+    // parameter attachments take on the audio thread for every automated change.
+    void requestRefresh(RefreshClient& client);
+    
+private:
+    juce::Array<RefreshClient*> clients;
+    std::unique_ptr<juce::VBlankAttachment> vBlank;
+    juce::Component* vBlankComponent = nullptr;
+    std::atomic<bool> isAwake {false};
+    std::atomic<bool> wakeRequested {false};
+    
+    void handleAsyncUpdate() override;
+    void wake();
+    void detach();
+    void tick();
+    bool attachToShowingClient();
+    bool hasPendingWork() const;
+    
+    JUCE_DECLARE_NON_COPYABLE(RefreshScheduler)
+};
@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    ResponseAnalysis.cpp
+    UI free frequency response analysis of ChainSettings.
+
+  ==============================================================================
+*/
+
+#include "ResponseAnalysis.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+    // Re( sum k p_k e^-jkw / sum p_k e^-jkw ), the group delay of one polynomial in z^-1
+    double getPolynomialGroupDelay(double p0, double p1, double p2, double omega) {
+        const std::complex<double> z1 = std::polar(1.0, -omega);
+        const std::complex<double> z2 = std::polar(1.0, -2.0 * omega);
+        const auto sum = p0 + p1 * z1 + p2 * z2;
+        const auto weighted = p1 * z1 + 2.0 * p2 * z2;
+        if (std::abs(sum) < 1.0e-12)
+            return 0.0;
+        return (weighted / sum).real();
+    }
+    
+    // |b0 + b1 z^-1 + b2 z^-2|^2 on the unit circle, written in phi = sin^2(w / 2). Unlike the
+    // cos(w), cos(2w) form nothing cancels at low frequencies, where poles close to z = 1 leave
+    // a denominator far below the rounding error of the individual terms.
+    double getPolynomialPower(double p0, double p1, double p2, double phi) {
+        const auto sum = p0 + p1 + p2;
+        return sum * sum - 4.0 * (p0 * p1 + p1 * p2 + 4.0 * p0 * p2) * phi + 16.0 * p0 * p2 * phi * phi;
+    }
+    
+    double getPhi(double frequency, double sampleRate) {
+        const auto sinHalfOmega = std::sin(juce::MathConstants<double>::pi * frequency / sampleRate);
+        return sinHalfOmega * sinHalfOmega;
+    }
+    
+    template<typename Function>
+    void forEachSection(const ChainCoefficients& coefficients, Function&& function) {
+        function(coefficients.peak);
+        for (int i = 0; i < coefficients.lowCut.numSections; i++) {
+            function(coefficients.lowCut[i]);
+        }
+        for (int i = 0; i < coefficients.highCut.numSections; i++) {
+            function(coefficients.highCut[i]);
+        }
+    }
+}
+
+//==============================================================================
+std::vector<double> makeLogFrequencyGrid(int numPoints, double minFrequency, double maxFrequency) {
+    std::vector<double> frequencies;
+    frequencies.resize((size_t)juce::jmax(0, numPoints));
+    for (int i = 0; i < numPoints; i++) {
+        frequencies[(size_t)i] = juce::mapToLog10(double(i) / numPoints, minFrequency, maxFrequency);
+    }
+    return frequencies;
+}
+
+
+std::complex<double> getComplexResponse(const BiquadCoefficients& coefficients, double frequency, double sampleRate) {
+    const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const std::complex<double> z1 = std::polar(1.0, -omega);
+    const std::complex<double> z2 = std::polar(1.0, -2.0 * omega);
+    const auto numerator = (double)coefficients.b0 + (double)coefficients.b1 * z1 + (double)coefficients.b2 * z2;
+    const auto denominator = 1.0 + (double)coefficients.a1 * z1 + (double)coefficients.a2 * z2;
+    return numerator / denominator;
+}
+
+
+double getGroupDelayInSamples(const BiquadCoefficients& coefficients, double frequency, double sampleRate) {
+    const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    return getPolynomialGroupDelay(coefficients.b0, coefficients.b1, coefficients.b2, omega)
+         - getPolynomialGroupDelay(1.0, coefficients.a1, coefficients.a2, omega);
+}
+
+
+double getMagnitudeForFrequency(const ChainCoefficients& coefficients, double frequency, double sampleRate) {
+    double magnitude = 1.0;
+    forEachSection(coefficients, [&](const BiquadCoefficients& section) {
+        magnitude *= std::abs(getComplexResponse(section, frequency, sampleRate));
+    });
+    return magnitude;
+}
+
+
+ChainResponse analyseResponse(const ChainSettings& chainSettings, double sampleRate, const std::vector<double>& frequencies) {
+    ChainResponse response;
+    response.frequencies = frequencies;
+    analyseResponse(makeChainCoefficients(chainSettings, sampleRate), sampleRate, response);
+    return response;
+}
+
+
+void analyseResponse(const ChainCoefficients& coefficients, double sampleRate, ChainResponse& response) {
+    // Uses response.frequencies as the grid and fills in the other arrays
+    const auto numPoints = response.frequencies.size();
+    response.magnitudeDecibels.resize(numPoints);
+    response.phaseRadians.resize(numPoints);
+    response.groupDelaySeconds.resize(numPoints);
+    
+    for (size_t i = 0; i < numPoints; i++) {
+        const auto frequency = response.frequencies[i];
+        std::complex<double> total = 1.0;
+        double groupDelay = 0.0;
+        forEachSection(coefficients, [&](const BiquadCoefficients& section) {
+            total *= getComplexResponse(section, frequency, sampleRate);
+            groupDelay += getGroupDelayInSamples(section, frequency, sampleRate);
+        });
+        
+        response.magnitudeDecibels[i] = juce::Decibels::gainToDecibels(std::abs(total), -200.0);
+        response.phaseRadians[i] = std::arg(total);
+        response.groupDelaySeconds[i] = groupDelay / sampleRate;
+    }
+    return;
+}
+
+
+std::vector<ChainResponse> analyseResponses(const std::vector<ChainSettings>& settings, double sampleRate,
+                                            const std::vector<double>& frequencies, int numThreads) {
+    std::vector<ChainResponse> responses(settings.size());
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+    numThreads = juce::jlimit(1, juce::jmax(1, (int)settings.size()), numThreads);
+    
+    // Each worker takes the next unclaimed entry, so uneven batches still balance
+    std::atomic<size_t> next {0};
+    auto worker = [&] {
+        for (auto i = next++; i < settings.size(); i = next++) {
+            responses[i].frequencies = frequencies;
+            analyseResponse(makeChainCoefficients(settings[i], sampleRate), sampleRate, responses[i]);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    return responses;
+}
+
+
+void LoudnessEstimator::prepare(double sampleRate, int numPoints) {
+    // Stay clear of Nyquist at low rates
+    const auto frequencies = makeLogFrequencyGrid(numPoints, 20.0, juce::jmin(20000.0, 0.45 * sampleRate));
+    const auto kWeighting = makeKWeightingFilter(sampleRate);
+    
+    phi.resize(frequencies.size());
+    weights.resize(frequencies.size());
+    totalWeight = 0.0;
+    
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        phi[i] = getPhi(frequencies[i], sampleRate);
+        
+        const auto kGain = std::abs(getComplexResponse(kWeighting[0], frequencies[i], sampleRate)
+                                  * getComplexResponse(kWeighting[1], frequencies[i], sampleRate));
+        weights[i] = kGain * kGain;
+        totalWeight += weights[i];
+    }
+    return;
+}
+
+
+float LoudnessEstimator::getCompensationGain(const ChainCoefficients& coefficients) const {
+    if (totalWeight <= 0.0)
+        return 1.0f;
+    
+    double weightedPower = 0.0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        double power = 1.0;
+        forEachSection(coefficients, [&](const BiquadCoefficients& section) {
+            const auto numerator = getPolynomialPower(section.b0, section.b1, section.b2, phi[i]);
+            const auto denominator = getPolynomialPower(1.0, section.a1, section.a2, phi[i]);
+            power *= numerator / juce::jmax(denominator, 1.0e-30);
+        });
+        weightedPower += weights[i] * power;
+    }
+    
+    // Power gain to amplitude: -10 log10 of the mean power in dB
+    const auto loudnessChange = 10.0 * std::log10(juce::jmax(weightedPower / totalWeight, 1.0e-30));
+    const auto compensation = juce::jlimit(-maxCompensationDecibels, maxCompensationDecibels, -loudnessChange);
+    return (float)juce::Decibels::decibelsToGain(compensation);
+}
+
+
+void MagnitudeEvaluator::prepare(const std::vector<double>& frequencies, double sampleRate) {
+    phi.resize(frequencies.size());
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        phi[i] = getPhi(frequencies[i], sampleRate);
+    }
+    return;
+}
+
+
+void MagnitudeEvaluator::getDecibels(const ChainCoefficients& coefficients, double* decibels) const {
+    for (size_t i = 0; i < phi.size(); i++) {
+        double power = 1.0;
+        forEachSection(coefficients, [&](const BiquadCoefficients& section) {
+            const auto numerator = getPolynomialPower(section.b0, section.b1, section.b2, phi[i]);
+            const auto denominator = getPolynomialPower(1.0, section.a1, section.a2, phi[i]);
+            power *= numerator / juce::jmax(denominator, 1.0e-30);
+        });
+        decibels[i] = 10.0 * std::log10(juce::jmax(power, 1.0e-20));
+    }
+    return;
+}
+
+
+void upgradeState(juce::ValueTree& state) {
+    const int version = state.getProperty(stateVersionProperty, 1);
+    if (version < 2) {
+        // Slope index k used to be 12 (k + 1) dB/Oct, the same slope is now index 2k + 1
+        for (auto child : state) {
+            if (!child.hasType("PARAM"))
+                continue;
+            
+            const auto id = child.getProperty("id").toString();
+            if (id == "Low-Cut Slope" || id == "High-Cut Slope") {
+                const auto index = juce::roundToInt((float)child.getProperty("value"));
+                child.setProperty("value", 2 * index + 1, nullptr);
+            }
+        }
+    }
+    state.setProperty(stateVersionProperty, currentStateVersion, nullptr);
+    return;
+}
+
+
+ChainSettings getChainSettings(const juce::ValueTree& savedState) {
+    auto state = savedState.createCopy();
+    upgradeState(state);
+    
+    // Defaults match SimpleEQAudioProcessor::createParameterLayout
+    ChainSettings settings;
+    settings.lowCutFreq = 20.0f;
+    settings.highCutFreq = 20000.0f;
+    settings.peakFreq = 750.0f;
+    settings.peakGainInDecibels = 0.0f;
+    settings.peakQuality = 1.0f;
+    
+    // APVTS stores one PARAM child per parameter with its unnormalised value. The file may come
+    // from anywhere, so choices are clamped before they become enums.
+    for (const auto& child : state) {
+        if (!child.hasType("PARAM"))
+            continue;
+        
+        const auto id = child.getProperty("id").toString();
+        const auto value = (float)child.getProperty("value");
+        if (id == "Low-Cut Freq") settings.lowCutFreq = value;
+        else if (id == "High-Cut Freq") settings.highCutFreq = value;
+        else if (id == "Peak Freq") settings.peakFreq = value;
+        else if (id == "Peak Gain") settings.peakGainInDecibels = value;
+        else if (id == "Peak Quality") settings.peakQuality = value;
+        else if (id == "Low-Cut Slope") settings.lowCutSlope = static_cast<Slope>(juce::jlimit(0, NumSlopes - 1, juce::roundToInt(value)));
+        else if (id == "High-Cut Slope") settings.highCutSlope = static_cast<Slope>(juce::jlimit(0, NumSlopes - 1, juce::roundToInt(value)));
+        else if (id == "Low-Cut Type") settings.lowCutType = static_cast<CutType>(juce::jlimit(0, NumCutTypes - 1, juce::roundToInt(value)));
+        else if (id == "High-Cut Type") settings.highCutType = static_cast<CutType>(juce::jlimit(0, NumCutTypes - 1, juce::roundToInt(value)));
+    }
+    
+    return settings;
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ResponseAnalysis.h
+    UI free frequency response analysis of ChainSettings.
+
+    Only depends on EQDesign, so it can be used from the editor, from
+    background threads or from command line tools without a processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <complex>
+#include <vector>
+
+#include "EQDesign.h"
+
+
+// Jake: Response of the whole chain evaluated on a frequency grid
+struct ChainResponse {
+    std::vector<double> frequencies;
+    std::vector<double> magnitudeDecibels;
+    std::vector<double> phaseRadians;           // wrapped to [-pi, pi]
+    std::vector<double> groupDelaySeconds;
+};
+
+
+// Jake: numPoints frequencies spaced evenly on a log axis, the same mapping the response curve uses
+std::vector<double> makeLogFrequencyGrid(int numPoints, double minFrequency = 20.0, double maxFrequency = 20000.0);
+
+std::complex<double> getComplexResponse(const BiquadCoefficients& coefficients, double frequency, double sampleRate);
+double getGroupDelayInSamples(const BiquadCoefficients& coefficients, double frequency, double sampleRate);
+// Jake: Magnitude of every active section at one frequency, from the coefficients alone
+double getMagnitudeForFrequency(const ChainCoefficients& coefficients, double frequency, double sampleRate);
+
+// Jake: Evaluates every active section designed for chainSettings at sampleRate
+ChainResponse analyseResponse(const ChainSettings& chainSettings, double sampleRate, const std::vector<double>& frequencies);
+void analyseResponse(const ChainCoefficients& coefficients, double sampleRate, ChainResponse& response);
+
+// Jake: Analyses a batch of settings split across numThreads worker threads (0 picks the core count)
+std::vector<ChainResponse> analyseResponses(const std::vector<ChainSettings>& settings, double sampleRate,
+                                            const std::vector<double>& frequencies, int numThreads = 0);
+
+// Jake: Estimates the loudness change of a designed chain from its coefficients alone: the power
+// gain |H|^2 averaged over a log frequency grid (equal weight per octave, like pink noise) and
+// weighted by the K-weighting curve. The trigonometry is done once in prepare(), an estimate is a
+// few multiply-adds per section and grid point and never allocates.
+struct LoudnessEstimator {
+    static constexpr double maxCompensationDecibels = 24.0;
+    
+    void prepare(double sampleRate, int numPoints = 64);
+    
+    // Linear gain that undoes the estimated loudness change, within +-maxCompensationDecibels
+    float getCompensationGain(const ChainCoefficients& coefficients) const;
+    
+private:
+    std::vector<double> phi;        // sin^2(w / 2) of each grid point
+    std::vector<double> weights;
+    double totalWeight = 0.0;
+};
+
+// Jake: Magnitude of designed chains on a fixed frequency grid, for searches that try many
+// candidate designs. Like LoudnessEstimator the trigonometry is done once in prepare() and an
+// evaluation is a few multiply-adds per section and grid point, without allocating.
+struct MagnitudeEvaluator {
+    void prepare(const std::vector<double>& frequencies, double sampleRate);
+    int getNumPoints() const { return (int)phi.size(); }
+    
+    // Writes getNumPoints() magnitudes in dB
+    void getDecibels(const ChainCoefficients& coefficients, double* decibels) const;
+    
+private:
+    std::vector<double> phi;
+};
+
+// Jake: Layout version stored on saved states. Version 1 (or no property) had four slope choices,
+// 12 to 48 dB/Oct, version 2 has sixteen, 6 to 96 dB/Oct, and the cut type parameters.
+constexpr const char* stateVersionProperty = "stateVersion";
+constexpr int currentStateVersion = 2;
+
+// Jake: Converts a saved state of an older layout in place, so old sessions keep their settings
+void upgradeState(juce::ValueTree& state);
+
+// Jake: Reads ChainSettings straight from a saved AudioProcessorValueTreeState tree, parameters
+// missing from the tree keep their default values
+ChainSettings getChainSettings(const juce::ValueTree& state);
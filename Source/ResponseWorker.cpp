@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    ResponseWorker.cpp
+    Background thread computing the chain's phase and group delay for display.
+
+  ==============================================================================
+*/
+
+#include "ResponseWorker.h"
+
+ResponseWorker::ResponseWorker() : juce::Thread("SimpleEQ Response") {
+    startThread(juce::Thread::Priority::low);
+}
+
+ResponseWorker::~ResponseWorker() {
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+}
+
+void ResponseWorker::request(const ChainSettings& chainSettings, double sampleRate, const std::vector<double>& frequencies) {
+    {
+        const juce::ScopedLock lock(requestLock);
+        requestedSettings = chainSettings;
+        requestedSampleRate = sampleRate;
+        requestedFrequencies = frequencies;
+        hasRequest = true;
+    }
+    notify();
+    return;
+}
+
+void ResponseWorker::run() {
+    while (!threadShouldExit()) {
+        ChainSettings chainSettings;
+        double sampleRate = 0.0;
+        {
+            const juce::ScopedLock lock(requestLock);
+            if (hasRequest) {
+                chainSettings = requestedSettings;
+                sampleRate = requestedSampleRate;
+                working.frequencies = requestedFrequencies;
+                hasRequest = false;
+            }
+        }
+        
+        if (sampleRate <= 0.0) {
+            wait(-1);
+            continue;
+        }
+        
+        analyseResponse(makeChainCoefficients(chainSettings, sampleRate), sampleRate, working);
+        {
+            const juce::SpinLock::ScopedLockType lock(publishLock);
+            std::swap(working, published);
+        }
+        ++generation;
+        
+        if (onResultReady != nullptr)
+            onResultReady();
+    }
+    return;
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    ResponseWorker.h
+    Background thread computing the chain's phase and group delay for display.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <functional>
+
+#include "ResponseAnalysis.h"
+
+
+// Jake: The editor posts requests and the worker analyses them off the message thread into
+// a private buffer, then swaps it with the published one. Paint only ever reads the published
+// buffer, under a lock that is held just for the swap.
+class ResponseWorker : private juce::Thread {
+public:
+    ResponseWorker();
+    ~ResponseWorker() override;
+    
+    // Called from the worker thread whenever a new result has been published
+    std::function<void()> onResultReady;
+    
+    // Message thread: replaces any request that hasn't been started yet
+    void request(const ChainSettings& chainSettings, double sampleRate, const std::vector<double>& frequencies);
+    
+    // Bumped every time a result is published
+    int getGeneration() const { return generation.load(); }
+    
+    // Calls reader with the latest published result while holding the swap lock
+    template<typename Reader>
+    void readLatest(Reader&& reader) const {
+        const juce::SpinLock::ScopedLockType lock(publishLock);
+        reader(published);
+    }
+    
+private:
+    void run() override;
+    
+    juce::CriticalSection requestLock;
+    bool hasRequest = false;
+    ChainSettings requestedSettings;
+    double requestedSampleRate = 0.0;
+    std::vector<double> requestedFrequencies;
+    
+    ChainResponse working;
+    ChainResponse published;
+    mutable juce::SpinLock publishLock;
+    std::atomic<int> generation {0};
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseWorker)
+};
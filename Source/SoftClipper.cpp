@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    SoftClipper.cpp
+    Optional output safety stage, a cubic soft clipper with first order ADAA.
+
+  ==============================================================================
+*/
+
+#include "SoftClipper.h"
+
+#include <bit>
+#include <cstdint>
+
+namespace {
+    constexpr float knee = 1.5f;
+    constexpr float cubic = 4.0f / 27.0f;
+
+    // Below this input step the difference quotient loses too many bits to cancellation and
+    // the curve at the midpoint is used instead, the two agree to O(step^2)
+    constexpr float minimumStep = 1.0e-3f;
+
+    // Picks a where the mask is all ones and b where it is zero, as bit operations so the
+    // vectoriser sees no control flow
+    inline float select(std::uint32_t mask, float a, float b) {
+        return std::bit_cast<float>((std::bit_cast<std::uint32_t>(a) & mask) | (std::bit_cast<std::uint32_t>(b) & ~mask));
+    }
+
+    inline std::uint32_t maskOf(bool condition) {
+        return 0u - (std::uint32_t)condition;
+    }
+
+    // Exact inside the range, +-limit outside it and for NaN
+    inline float clampTo(float x, float limit) {
+        return select(maskOf(std::abs(x) <= limit), x, std::copysign(limit, x));
+    }
+
+    inline float getCurve(float x) {
+        const auto c = clampTo(x, knee);
+        return c - cubic * c * c * c;
+    }
+
+    // F(x) - F(p) for F(x) = x^2 / 2 - x^4 / 27 inside the knee, continued with slope 1 outside.
+    // The polynomial and linear parts are differenced separately, so two loud samples on the
+    // same side don't lose the step to the size of F.
+    inline float getAntiderivativeDifference(float x, float p) {
+        const auto cx = clampTo(x, knee);
+        const auto cp = clampTo(p, knee);
+        const auto cx2 = cx * cx;
+        const auto cp2 = cp * cp;
+        const auto polynomial = 0.5f * (cx2 - cp2) - (cx2 * cx2 - cp2 * cp2) * (1.0f / 27.0f);
+        const auto linear = (std::abs(x) - std::abs(p)) - (std::abs(cx) - std::abs(cp));
+        return polynomial + linear;
+    }
+
+    inline float getSoftClipSample(float x, float previous) {
+        const auto sum = x + previous;
+        const auto step = x - previous;
+
+        // Both inside the knee: (F(x) - F(p)) / (x - p) divides out exactly
+        const auto inside = 0.5f * sum - sum * (x * x + previous * previous) * (1.0f / 27.0f);
+
+        const auto largeStep = maskOf(std::abs(step) > minimumStep);
+        const auto quotient = getAntiderivativeDifference(x, previous) / select(largeStep, step, 1.0f);
+        const auto outside = select(largeStep, quotient, getCurve(0.5f * sum));
+
+        const auto isInside = maskOf((std::abs(x) <= knee) & (std::abs(previous) <= knee));
+        return clampTo(select(isInside, inside, outside), 1.0f);
+    }
+}
+
+//==============================================================================
+float softClip(float x) {
+    return getCurve(x);
+}
+
+
+int processSoftClip(float* data, float& previousInput, float* scratch, int numSamples) {
+    if (numSamples <= 0)
+        return 0;
+
+    // The input one sample behind, so the loop reads two arrays and carries nothing
+    scratch[0] = previousInput;
+    juce::FloatVectorOperations::copy(scratch + 1, data, numSamples - 1);
+    previousInput = data[numSamples - 1];
+
+    int numClipped = 0;
+    for (int i = 0; i < numSamples; i++) {
+        numClipped += std::abs(data[i]) > 1.0f ? 1 : 0;
+        data[i] = getSoftClipSample(data[i], scratch[i]);
+    }
+    return numClipped;
+}
+
+
+//==============================================================================
+void SoftClipper::prepare(int maximumBlockSize, int numChannels) {
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    numClippedChannels = juce::jmin(numChannels, maxChannels);
+    scratch.assign((size_t)maxBlockSize, 0.0f);
+    reset();
+    return;
+}
+
+
+void SoftClipper::release() {
+    scratch = {};
+    maxBlockSize = 0;
+    return;
+}
+
+
+void SoftClipper::process(juce::AudioBuffer<float>& buffer) {
+    if (maxBlockSize <= 0)
+        return;
+
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), numClippedChannels);
+    const auto numSamples = buffer.getNumSamples();
+    if (!isPrimed && numSamples > 0) {
+        for (int ch = 0; ch < numChannels; ch++) {
+            previousInput[(size_t)ch] = buffer.getSample(ch, 0);
+        }
+        isPrimed = true;
+    }
+
+    // Hosts may send more than they announced, the scratch covers one prepared block
+    int numClipped = 0;
+    for (int ch = 0; ch < numChannels; ch++) {
+        auto* data = buffer.getWritePointer(ch);
+        for (int start = 0; start < numSamples; start += maxBlockSize) {
+            const auto length = juce::jmin(maxBlockSize, numSamples - start);
+            numClipped += processSoftClip(data + start, previousInput[(size_t)ch], scratch.data(), length);
+        }
+    }
+
+    if (numClipped > 0)
+        clipCount.fetch_add((juce::uint64)numClipped, std::memory_order_relaxed);
+    return;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    SoftClipper.h
+    Optional output safety stage, a cubic soft clipper with first order ADAA.
+
+    f(x) = x - 4/27 x^3 up to |x| = 1.5 and +-1 beyond, so the output never
+    leaves 0 dBFS and the curve has no corner. Antiderivative anti-aliasing
+    replaces f by the difference quotient of its antiderivative over each
+    pair of input samples, which keeps the aliasing of the saturation down
+    without oversampling. Nothing is reported as latency, ADAA only adds
+    half a sample of group delay.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+
+// Jake: The static curve, the antiderivative-free reference for the ADAA kernel
+float softClip(float x);
+
+// Jake: ADAA soft clip of numSamples in place. previousInput carries the last input sample over
+// from the previous call, scratch holds numSamples floats. Returns the number of input samples
+// past 0 dBFS, the ones that would have clipped without the stage.
+int processSoftClip(float* data, float& previousInput, float* scratch, int numSamples);
+
+
+// Jake: Runs the kernel on up to maxChannels channels. Scratch is allocated in prepare(),
+// process() doesn't allocate and keeps a running clip count for the editor.
+class SoftClipper {
+public:
+    static constexpr int maxChannels = 2;
+
+    void prepare(int maximumBlockSize, int numChannels);
+    void release();
+
+    // The first block after a reset starts from its own first sample, not from silence
+    void reset() { isPrimed = false; }
+
+    // Audio thread
+    void process(juce::AudioBuffer<float>& buffer);
+
+    // Any thread: input samples past 0 dBFS since the processor was created
+    juce::uint64 getClipCount() const { return clipCount.load(std::memory_order_relaxed); }
+
+private:
+    int maxBlockSize = 0;
+    int numClippedChannels = 0;
+    bool isPrimed = false;
+    std::array<float, maxChannels> previousInput {};
+    std::vector<float> scratch;
+
+    std::atomic<juce::uint64> clipCount {0};
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    StandaloneApp.cpp
+    Application class of the Standalone target.
+
+    Without arguments this is JUCE's stock standalone window. With --headless
+    the processor runs under LatencyRig instead and the app quits when the
+    run is over, with exit code 2 if any callback missed its deadline.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+
+#include "LatencyRig.h"
+
+
+// Jake: Same behaviour as juce::StandaloneFilterApp plus the headless mode
+class SimpleEQStandaloneApp : public juce::JUCEApplication {
+public:
+    SimpleEQStandaloneApp() {
+        juce::PropertiesFile::Options options;
+        options.applicationName = getApplicationName();
+        options.filenameSuffix = ".settings";
+        options.osxLibrarySubFolder = "Application Support";
+       #if JUCE_LINUX || JUCE_BSD
+        options.folderName = "~/.config";
+       #else
+        options.folderName = "";
+       #endif
+        appProperties.setStorageParameters(options);
+    }
+
+    const juce::String getApplicationName() override { return JucePlugin_Name; }
+    const juce::String getApplicationVersion() override { return JucePlugin_VersionString; }
+    bool moreThanOneInstanceAllowed() override { return true; }
+    void anotherInstanceStarted(const juce::String&) override {}
+
+    void initialise(const juce::String&) override {
+        const juce::ArgumentList args(getApplicationName(), getCommandLineParameterArray());
+        if (args.containsOption("--headless")) {
+            rig = std::make_unique<LatencyRig>(LatencyRig::Options::fromArguments(args));
+            rig->start([this] (int exitCode) {
+                setApplicationReturnValue(exitCode);
+                quit();
+            });
+            return;
+        }
+
+        mainWindow = std::make_unique<juce::StandaloneFilterWindow>(getApplicationName(),
+                                                                    juce::LookAndFeel::getDefaultLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId),
+                                                                    appProperties.getUserSettings(),
+                                                                    false);
+        mainWindow->setVisible(true);
+        return;
+    }
+
+    void shutdown() override {
+        rig = nullptr;
+        mainWindow = nullptr;
+        appProperties.saveIfNeeded();
+        return;
+    }
+
+    void systemRequestedQuit() override {
+        if (mainWindow != nullptr)
+            mainWindow->pluginHolder->savePluginState();
+
+        // Give modal dialogs a chance to close first
+        if (juce::ModalComponentManager::getInstance()->cancelAllModalComponents()) {
+            juce::Timer::callAfterDelay(100, [] {
+                if (auto* app = juce::JUCEApplicationBase::getInstance())
+                    app->systemRequestedQuit();
+            });
+            return;
+        }
+        quit();
+        return;
+    }
+
+private:
+    juce::ApplicationProperties appProperties;
+    std::unique_ptr<juce::StandaloneFilterWindow> mainWindow;
+    std::unique_ptr<LatencyRig> rig;
+};
+
+
+JUCE_CREATE_APPLICATION_DEFINE(SimpleEQStandaloneApp)
+
+#endif
@@ -0,0 +1,426 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+    Optional binary trace of what the processor did, for offline profiling.
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+
+#include <cstring>
+#include <limits>
+
+namespace {
+    // File layout: magic, version, ticks per second, parameter names, then records to the end
+    constexpr char traceMagic[] = "SEQTRACE";
+    constexpr int traceMagicSize = 8;
+    constexpr int traceVersion = 1;
+    constexpr int recordSizeOnDisk = 24;
+    constexpr int maxParameters = 4096;
+
+    // Marks where a recording starts in the ring, count holds its session. Never written to disk.
+    constexpr juce::uint16 sessionMarkType = 0xffff;
+
+    // A block starting this much later than the previous block's audio ran out is suspect. Gaps
+    // past a second are taken for a stopped transport or an offline render, not for a dropout.
+    constexpr double lateCallbackRatio = 1.5;
+    constexpr double maxCallbackGapSeconds = 1.0;
+
+    void writeRecord(juce::OutputStream& stream, const TraceRecord& record) {
+        stream.writeInt64(record.ticks);
+        stream.writeInt((int)record.durationNanoseconds);
+        stream.writeFloat(record.value);
+        stream.writeShort((short)record.type);
+        stream.writeShort((short)record.index);
+        stream.writeInt((int)record.count);
+        return;
+    }
+
+    TraceRecord readRecord(juce::InputStream& stream) {
+        TraceRecord record;
+        record.ticks = stream.readInt64();
+        record.durationNanoseconds = (juce::uint32)stream.readInt();
+        record.value = stream.readFloat();
+        record.type = (juce::uint16)stream.readShort();
+        record.index = (juce::uint16)stream.readShort();
+        record.count = (juce::uint32)stream.readInt();
+        return record;
+    }
+
+    juce::String toMicroseconds(juce::int64 ticks, juce::int64 ticksPerSecond) {
+        return juce::String(1.0e6 * (double)ticks / (double)ticksPerSecond, 3);
+    }
+}
+
+//==============================================================================
+TraceRecorder::TraceRecorder()
+    : juce::Thread("SimpleEQ Trace"), ticksPerSecond((double)juce::Time::getHighResolutionTicksPerSecond()) {
+}
+
+
+TraceRecorder::~TraceRecorder() {
+    stop();
+}
+
+
+void TraceRecorder::watchParameters(const juce::Array<juce::AudioProcessorParameter*>& processorParameters) {
+    jassert(!isRecording());
+    parameters.clear();
+    for (auto* parameter : processorParameters) {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parameters.add(ranged);
+    }
+    lastValues.assign((size_t)parameters.size(), 0.0f);
+    return;
+}
+
+
+bool TraceRecorder::start(const juce::File& file) {
+    stop();
+
+    auto output = std::make_unique<juce::FileOutputStream>(file);
+    if (!output->openedOk() || !output->setPosition(0) || !output->truncate().wasOk())
+        return false;
+
+    output->write(traceMagic, traceMagicSize);
+    output->writeInt(traceVersion);
+    output->writeInt64(juce::Time::getHighResolutionTicksPerSecond());
+    output->writeInt(parameters.size());
+    for (auto* parameter : parameters) {
+        output->writeString(parameter->getParameterID());
+    }
+    stream = std::move(output);
+
+    // The ring is kept once allocated, the audio thread may still be finishing a push into it.
+    // Its own state restarts on its next block, the records it leaves before then are skipped.
+    if (ring.empty())
+        ring.resize((size_t)ringSize);
+    writerSession = requestedSession.load(std::memory_order_relaxed) + 1;
+    hasReachedMark = false;
+    startTicks = juce::Time::getHighResolutionTicks();
+    requestedSession.store(writerSession, std::memory_order_release);
+
+    recording.store(true, std::memory_order_release);
+    startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+
+void TraceRecorder::stop() {
+    if (!isRecording())
+        return;
+
+    recording.store(false, std::memory_order_release);
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+    stream = nullptr;
+    return;
+}
+
+
+//==============================================================================
+void TraceRecorder::prepare(double newSampleRate) {
+    sampleRate.store(newSampleRate);
+    previousBlockStart = -1;
+    return;
+}
+
+
+juce::int64 TraceRecorder::getTicks() const {
+    return juce::Time::getHighResolutionTicks();
+}
+
+
+juce::uint32 TraceRecorder::toNanoseconds(juce::int64 ticks) const {
+    const auto nanoseconds = 1.0e9 * (double)ticks / ticksPerSecond;
+    return (juce::uint32)juce::jlimit(0.0, (double)std::numeric_limits<juce::uint32>::max(), nanoseconds);
+}
+
+
+void TraceRecorder::beginBlock() {
+    if (!isRecording())
+        return;
+
+    // The first block of a recording starts over here, on the thread that owns this state
+    const auto session = requestedSession.load(std::memory_order_acquire);
+    if (session != audioSession) {
+        audioSession = session;
+        isMarkPending = true;
+        numDropped.store(0, std::memory_order_relaxed);
+        previousBlockStart = -1;
+        std::fill(lastValues.begin(), lastValues.end(), std::numeric_limits<float>::quiet_NaN());
+    }
+
+    // Nothing is recorded until the mark is in. A full ring takes it once the writer made room.
+    if (isMarkPending) {
+        if (fifo.getFreeSpace() < 1)
+            return;
+
+        sessionStartTicks = getTicks();
+        TraceRecord mark;
+        mark.ticks = sessionStartTicks;
+        mark.type = sessionMarkType;
+        mark.count = session;
+        push(mark);
+        isMarkPending = false;
+    }
+
+    addParameterChanges();
+    return;
+}
+
+
+void TraceRecorder::addParameterChanges() {
+    // Only what the audio thread sees, once per block, so the trace shows the changes as they
+    // reached the filters however often the host or the editor set them in between
+    const auto ticks = getTicks();
+    for (int i = 0; i < parameters.size(); i++) {
+        auto* parameter = parameters.getUnchecked(i);
+        const auto value = parameter->convertFrom0to1(parameter->getValue());
+        auto& lastValue = lastValues[(size_t)i];
+        if (value == lastValue)
+            continue;
+
+        lastValue = value;
+        TraceRecord record;
+        record.ticks = ticks;
+        record.value = value;
+        record.type = TraceEvent_ParameterChange;
+        record.index = (juce::uint16)i;
+        push(record);
+    }
+    return;
+}
+
+
+void TraceRecorder::addEvent(TraceEventType type, juce::int64 eventStartTicks, juce::uint32 count) {
+    // Events that began before the mark belong to no recording
+    if (!isRecording() || isMarkPending || eventStartTicks < sessionStartTicks)
+        return;
+
+    const auto endTicks = getTicks();
+    if (type == TraceEvent_Block) {
+        addBlock(eventStartTicks, endTicks, count);
+        return;
+    }
+
+    TraceRecord record;
+    record.ticks = eventStartTicks;
+    record.durationNanoseconds = toNanoseconds(endTicks - eventStartTicks);
+    record.type = (juce::uint16)type;
+    record.count = count;
+    push(record);
+    return;
+}
+
+
+void TraceRecorder::addBlock(juce::int64 blockStartTicks, juce::int64 endTicks, juce::uint32 numSamples) {
+    const auto rate = sampleRate.load();
+    const auto blockTicks = rate > 0.0 ? ticksPerSecond * (double)numSamples / rate : 0.0;
+    const auto processTicks = (double)(endTicks - blockStartTicks);
+
+    TraceRecord block;
+    block.ticks = blockStartTicks;
+    block.durationNanoseconds = toNanoseconds(endTicks - blockStartTicks);
+    block.value = blockTicks > 0.0 ? (float)(processTicks / blockTicks) : 0.0f;
+    block.type = TraceEvent_Block;
+    block.count = numSamples;
+    push(block);
+
+    const auto overBudget = blockTicks > 0.0 && processTicks > blockTicks;
+    if (overBudget) {
+        TraceRecord xrun;
+        xrun.ticks = endTicks;
+        xrun.value = block.value;
+        xrun.type = TraceEvent_XrunSuspected;
+        xrun.index = TraceXrun_OverBudget;
+        xrun.count = numSamples;
+        push(xrun);
+    }
+
+    // The previous block's audio lasts previousBlockTicks from its start. A block that overran
+    // delays the next one, that start was flagged with it already.
+    if (previousBlockStart >= 0 && previousBlockTicks > 0.0 && !previousBlockOverBudget) {
+        const auto gap = (double)(blockStartTicks - previousBlockStart);
+        if (gap > lateCallbackRatio * previousBlockTicks && gap < maxCallbackGapSeconds * ticksPerSecond) {
+            TraceRecord xrun;
+            xrun.ticks = blockStartTicks;
+            xrun.value = (float)(gap / previousBlockTicks);
+            xrun.type = TraceEvent_XrunSuspected;
+            xrun.index = TraceXrun_LateCallback;
+            xrun.count = numSamples;
+            push(xrun);
+        }
+    }
+    previousBlockStart = blockStartTicks;
+    previousBlockTicks = blockTicks;
+    previousBlockOverBudget = overBudget;
+    return;
+}
+
+
+void TraceRecorder::push(const TraceRecord& record) {
+    // Records that don't fit are counted, the count goes in as soon as there is room again
+    if (numDropped.load(std::memory_order_relaxed) > 0 && fifo.getFreeSpace() >= 2)
+        writeDropped(record.ticks);
+
+    if (fifo.getFreeSpace() < 1) {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    ring[(size_t)(size1 > 0 ? start1 : start2)] = record;
+    fifo.finishedWrite(1);
+    return;
+}
+
+
+void TraceRecorder::writeDropped(juce::int64 ticks) {
+    TraceRecord dropped;
+    dropped.ticks = ticks;
+    dropped.type = TraceEvent_RecordsDropped;
+    dropped.count = numDropped.exchange(0);
+    if (dropped.count == 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    ring[(size_t)(size1 > 0 ? start1 : start2)] = dropped;
+    fifo.finishedWrite(1);
+    return;
+}
+
+
+//==============================================================================
+void TraceRecorder::run() {
+    while (!threadShouldExit()) {
+        writePending();
+        wait(flushIntervalMilliseconds);
+    }
+
+    // Whatever the audio thread got in before recording stopped, and what it had to drop
+    writePending();
+    if (const auto dropped = hasReachedMark ? numDropped.exchange(0) : 0; dropped > 0) {
+        TraceRecord record;
+        record.ticks = juce::Time::getHighResolutionTicks() - startTicks;
+        record.type = TraceEvent_RecordsDropped;
+        record.count = dropped;
+        writeRecord(*stream, record);
+    }
+    stream->flush();
+    return;
+}
+
+
+void TraceRecorder::writePending() {
+    auto write = [this] (TraceRecord record) {
+        // Anything before this recording's mark was left in the ring by an earlier one
+        if (!hasReachedMark) {
+            hasReachedMark = record.type == sessionMarkType && record.count == writerSession;
+            return;
+        }
+        record.ticks -= startTicks;
+        writeRecord(*stream, record);
+    };
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; i++) {
+        write(ring[(size_t)(start1 + i)]);
+    }
+    for (int i = 0; i < size2; i++) {
+        write(ring[(size_t)(start2 + i)]);
+    }
+    fifo.finishedRead(size1 + size2);
+    return;
+}
+
+
+//==============================================================================
+std::optional<TraceFile> readTraceFile(const juce::File& file) {
+    juce::FileInputStream input(file);
+    if (!input.openedOk())
+        return std::nullopt;
+
+    char magic[traceMagicSize] = {};
+    if (input.read(magic, traceMagicSize) != traceMagicSize || std::memcmp(magic, traceMagic, traceMagicSize) != 0)
+        return std::nullopt;
+    if (input.readInt() != traceVersion)
+        return std::nullopt;
+
+    TraceFile trace;
+    trace.ticksPerSecond = input.readInt64();
+    const auto numParameters = input.readInt();
+    if (trace.ticksPerSecond <= 0 || numParameters < 0 || numParameters > maxParameters)
+        return std::nullopt;
+    for (int i = 0; i < numParameters; i++) {
+        trace.parameterNames.add(input.readString());
+    }
+
+    const auto remaining = input.getTotalLength() - input.getPosition();
+    trace.records.reserve((size_t)juce::jmax((juce::int64)0, remaining / recordSizeOnDisk));
+    while (input.getTotalLength() - input.getPosition() >= recordSizeOnDisk) {
+        trace.records.push_back(readRecord(input));
+    }
+    return trace;
+}
+
+
+void writeChromeTrace(const TraceFile& trace, juce::OutputStream& json) {
+    const auto tps = trace.ticksPerSecond;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SimpleEQ\"}},\n";
+    json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Audio thread\"}}";
+
+    for (const auto& record : trace.records) {
+        // Written by a newer version
+        if (record.type >= NumTraceEventTypes)
+            continue;
+
+        const auto ts = toMicroseconds(record.ticks, tps);
+        const auto dur = juce::String(1.0e-3 * (double)record.durationNanoseconds, 3);
+        json << ",\n";
+
+        switch (record.type) {
+            case TraceEvent_Block:
+                json << "{\"name\":\"processBlock\",\"cat\":\"audio\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << ts
+                     << ",\"dur\":" << dur << ",\"args\":{\"samples\":" << (int)record.count
+                     << ",\"load\":" << juce::String(record.value, 4) << "}}";
+                break;
+
+            case TraceEvent_CoefficientRebuild:
+                json << "{\"name\":\"Coefficient rebuild\",\"cat\":\"audio\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << ts
+                     << ",\"dur\":" << dur << "}";
+                break;
+
+            case TraceEvent_ParameterChange: {
+                const auto name = juce::isPositiveAndBelow((int)record.index, trace.parameterNames.size())
+                                ? trace.parameterNames[(int)record.index]
+                                : "Parameter " + juce::String(record.index);
+                json << "{\"name\":" << juce::JSON::toString(name) << ",\"cat\":\"parameters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << ts
+                     << ",\"args\":{\"value\":" << juce::String(record.value, 6) << "}}";
+                break;
+            }
+
+            case TraceEvent_XrunSuspected:
+                json << "{\"name\":\"Xrun suspected\",\"cat\":\"audio\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":" << ts
+                     << ",\"args\":{\"reason\":\"" << (record.index == TraceXrun_LateCallback ? "late callback" : "over budget")
+                     << "\",\"ratio\":" << juce::String(record.value, 3) << "}}";
+                break;
+
+            case TraceEvent_RecordsDropped:
+            default:
+                json << "{\"name\":\"Records dropped\",\"cat\":\"trace\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":1,\"ts\":" << ts
+                     << ",\"args\":{\"count\":" << (int)record.count << "}}";
+                break;
+        }
+    }
+
+    json << "\n]}\n";
+    return;
+}
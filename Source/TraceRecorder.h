@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Optional binary trace of what the processor did, for offline profiling.
+
+    While recording, the audio thread writes fixed size records for every
+    block, coefficient rebuild, parameter change it picks up and suspected
+    xrun into a preallocated ring. A background thread drains the ring into
+    a file. readTraceFile() and writeChromeTrace() turn a trace into Chrome
+    trace-event JSON for timeline viewers such as Perfetto or chrome://tracing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <optional>
+#include <vector>
+
+
+// Jake: What a record describes
+enum TraceEventType {
+    TraceEvent_Block,               // count: samples, value: processing time over the block's duration
+    TraceEvent_CoefficientRebuild,  // a redesign of the chain on the audio thread
+    TraceEvent_ParameterChange,     // index: parameter, value: new value in the parameter's own units
+    TraceEvent_XrunSuspected,       // index: TraceXrunReason, value: how far over, as a ratio
+    TraceEvent_RecordsDropped,      // count: records lost because the ring was full
+    NumTraceEventTypes
+};
+
+// Jake: Why a block was flagged. The plugin can't see the device, so these are suspicions only.
+enum TraceXrunReason {
+    TraceXrun_OverBudget,           // processing took longer than the audio it produced
+    TraceXrun_LateCallback,         // the block started well after the previous one's audio ran out
+    NumTraceXrunReasons
+};
+
+// Jake: One record, 24 bytes in memory and on disk. Times are high resolution ticks since the
+// recording started, durations are nanoseconds.
+struct TraceRecord {
+    juce::int64 ticks = 0;
+    juce::uint32 durationNanoseconds = 0;
+    float value = 0.0f;
+    juce::uint16 type = 0;
+    juce::uint16 index = 0;
+    juce::uint32 count = 0;
+};
+
+
+// Jake: Records a trace of one processor. Only the audio thread adds records, so the ring has a
+// single producer and a single consumer. Nothing is allocated until the first recording starts.
+// Recordings may start and stop while the audio thread runs: start() only bumps a session
+// number, the audio thread resets its own state on its next block and marks the ring there, and
+// the writer skips whatever is older than the mark. The message thread never touches the ring.
+class TraceRecorder : private juce::Thread {
+public:
+    static constexpr int ringSize = 1 << 16;
+    static constexpr int flushIntervalMilliseconds = 100;
+
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    // Message thread, before recording. Parameter changes are recorded by index into this list.
+    void watchParameters(const juce::Array<juce::AudioProcessorParameter*>& parameters);
+
+    // Message thread. Starting replaces file, stopping writes out what is left in the ring.
+    bool start(const juce::File& file);
+    void stop();
+    bool isRecording() const { return recording.load(std::memory_order_acquire); }
+
+    // Audio thread, all of them return straight away unless recording. beginBlock() goes first
+    // in every block, it picks up a new recording and the parameter changes.
+    void prepare(double sampleRate);
+    void beginBlock();
+    void addEvent(TraceEventType type, juce::int64 startTicks, juce::uint32 count = 0);
+    juce::int64 getTicks() const;
+
+private:
+    void run() override;
+    void addParameterChanges();
+    void push(const TraceRecord& record);
+    void writeDropped(juce::int64 ticks);
+    void addBlock(juce::int64 startTicks, juce::int64 endTicks, juce::uint32 numSamples);
+    void writePending();
+    juce::uint32 toNanoseconds(juce::int64 ticks) const;
+
+    std::atomic<bool> recording {false};
+    std::atomic<juce::uint32> requestedSession {0};     // bumped by every start()
+    const double ticksPerSecond;
+
+    // Audio thread side. Ticks in the ring are absolute, the writer makes them relative.
+    juce::AbstractFifo fifo {ringSize};
+    std::vector<TraceRecord> ring;
+    std::atomic<juce::uint32> numDropped {0};
+    std::atomic<double> sampleRate {0.0};
+    juce::uint32 audioSession = 0;
+    bool isMarkPending = false;
+    juce::int64 sessionStartTicks = 0;
+    juce::int64 previousBlockStart = -1;
+    double previousBlockTicks = 0.0;
+    bool previousBlockOverBudget = false;
+
+    // Plain values last recorded, NaN forces the first block of a recording to record all of them
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    std::vector<float> lastValues;
+
+    // Writer thread side, set up by start() before the thread runs
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::uint32 writerSession = 0;
+    bool hasReachedMark = false;
+    juce::int64 startTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
+
+
+// Jake: Adds one record covering its scope, nothing when the recorder isn't recording
+struct ScopedTraceEvent {
+    ScopedTraceEvent(TraceRecorder& r, TraceEventType t, juce::uint32 c = 0)
+        : recorder(r.isRecording() ? &r : nullptr), type(t), count(c), start(recorder != nullptr ? recorder->getTicks() : 0) {}
+    ~ScopedTraceEvent() {
+        if (recorder != nullptr)
+            recorder->addEvent(type, start, count);
+    }
+
+private:
+    TraceRecorder* recorder;
+    TraceEventType type;
+    juce::uint32 count;
+    juce::int64 start;
+};
+
+
+// Jake: A trace read back from disk
+struct TraceFile {
+    juce::int64 ticksPerSecond = 0;
+    juce::StringArray parameterNames;
+    std::vector<TraceRecord> records;
+};
+
+// Jake: Nothing if the file isn't a trace. A trace cut short keeps the records that are complete.
+std::optional<TraceFile> readTraceFile(const juce::File& file);
+
+// Jake: Chrome trace-event JSON. Blocks and rebuilds are complete events on the audio thread's
+// track, parameters are counters and suspected xruns are global instant events.
+void writeChromeTrace(const TraceFile& trace, juce::OutputStream& json);
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    AnalyseCommand.cpp
+    Batch response analysis of saved SimpleEQ states.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/ResponseAnalysis.h"
+
+#include <iostream>
+
+namespace {
+    double getDoubleOption(const juce::ArgumentList& args, const juce::String& option, double defaultValue) {
+        if (!args.containsOption(option))
+            return defaultValue;
+        return args.getValueForOption(option).getDoubleValue();
+    }
+    
+    bool loadState(const juce::File& file, juce::ValueTree& state) {
+        juce::MemoryBlock data;
+        if (!file.loadFileAsData(data))
+            return false;
+        
+        // Binary blob from getStateInformation first, then the XML form
+        state = juce::ValueTree::readFromData(data.getData(), data.getSize());
+        if (!state.isValid()) {
+            if (auto xml = juce::parseXML(data.toString()))
+                state = juce::ValueTree::fromXml(*xml);
+        }
+        return state.isValid();
+    }
+    
+    void writeCsv(const juce::File& file, const ChainResponse& response) {
+        juce::String csv;
+        csv << "frequency_hz,magnitude_db,phase_rad,group_delay_s\n";
+        for (size_t i = 0; i < response.frequencies.size(); i++) {
+            csv << response.frequencies[i] << ","
+                << response.magnitudeDecibels[i] << ","
+                << response.phaseRadians[i] << ","
+                << response.groupDelaySeconds[i] << "\n";
+        }
+        file.replaceWithText(csv);
+    }
+}
+
+void runAnalyse(const juce::ArgumentList& args) {
+    const auto sampleRate = getDoubleOption(args, "--rate", 48000.0);
+    const auto numPoints = (int)getDoubleOption(args, "--points", 512);
+    const auto numThreads = (int)getDoubleOption(args, "--threads", 0);
+    const auto boostThreshold = getDoubleOption(args, "--boost-threshold", 6.0);
+    const auto cutThreshold = getDoubleOption(args, "--cut-threshold", -3.0);
+    
+    auto vocalLow = 300.0;
+    auto vocalHigh = 3400.0;
+    if (args.containsOption("--vocal-range")) {
+        auto range = args.getValueForOption("--vocal-range");
+        vocalLow = range.upToFirstOccurrenceOf(":", false, false).getDoubleValue();
+        vocalHigh = range.fromFirstOccurrenceOf(":", false, false).getDoubleValue();
+    }
+    
+    if (sampleRate <= 0.0 || numPoints <= 1 || vocalLow >= vocalHigh)
+        juce::ConsoleApplication::fail("Invalid --rate, --points or --vocal-range");
+    
+    // Everything that isn't an option (or the command itself) is a state file
+    juce::Array<juce::File> files;
+    for (int i = 1; i < args.size(); i++) {
+        if (!args[i].isOption())
+            files.add(args[i].resolveAsFile());
+    }
+    if (files.isEmpty())
+        juce::ConsoleApplication::fail("No state files given");
+    
+    std::vector<ChainSettings> settings;
+    juce::Array<juce::File> loaded;
+    for (auto& file : files) {
+        juce::ValueTree state;
+        if (!loadState(file, state)) {
+            std::cerr << "Skipping unreadable state: " << file.getFullPathName() << std::endl;
+            continue;
+        }
+        settings.push_back(getChainSettings(state));
+        loaded.add(file);
+    }
+    
+    const auto frequencies = makeLogFrequencyGrid(numPoints);
+    const auto responses = analyseResponses(settings, sampleRate, frequencies, numThreads);
+    
+    // The range ends are always evaluated, a narrow range may have no grid point inside it
+    const auto vocalEnds = analyseResponses(settings, sampleRate, {vocalLow, vocalHigh}, numThreads);
+    
+    juce::File csvDirectory;
+    if (args.containsOption("--csv")) {
+        csvDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--csv"));
+        csvDirectory.createDirectory();
+    }
+    
+    std::cout << "file,max_gain_db,max_gain_hz,min_vocal_gain_db,min_vocal_gain_hz,flags" << std::endl;
+    int numFlagged = 0;
+    for (size_t i = 0; i < responses.size(); i++) {
+        const auto& response = responses[i];
+        
+        size_t maxIndex = 0;
+        auto minVocal = vocalEnds[i].magnitudeDecibels[0];
+        auto minVocalFrequency = vocalLow;
+        if (vocalEnds[i].magnitudeDecibels[1] < minVocal) {
+            minVocal = vocalEnds[i].magnitudeDecibels[1];
+            minVocalFrequency = vocalHigh;
+        }
+        for (size_t j = 0; j < frequencies.size(); j++) {
+            if (response.magnitudeDecibels[j] > response.magnitudeDecibels[maxIndex])
+                maxIndex = j;
+            if (frequencies[j] > vocalLow && frequencies[j] < vocalHigh && response.magnitudeDecibels[j] < minVocal) {
+                minVocal = response.magnitudeDecibels[j];
+                minVocalFrequency = frequencies[j];
+            }
+        }
+        
+        juce::StringArray flags;
+        if (response.magnitudeDecibels[maxIndex] > boostThreshold)
+            flags.add("BOOST");
+        if (minVocal < cutThreshold)
+            flags.add("VOCAL_CUT");
+        if (!flags.isEmpty())
+            ++numFlagged;
+        
+        std::cout << loaded[(int)i].getFullPathName() << ","
+                  << response.magnitudeDecibels[maxIndex] << "," << frequencies[maxIndex] << ","
+                  << minVocal << "," << minVocalFrequency << ","
+                  << flags.joinIntoString(" ") << std::endl;
+        
+        if (csvDirectory.isDirectory())
+            writeCsv(csvDirectory.getChildFile(loaded[(int)i].getFileNameWithoutExtension() + ".csv"), response);
+    }
+    
+    // Non-zero exit so QA scripts can fail on flagged sessions
+    if (numFlagged > 0)
+        juce::ConsoleApplication::fail(juce::String(numFlagged) + " state(s) flagged", 2);
+    return;
+}
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    BenchCommand.cpp
+    Multi-instance hosting stress benchmark of SimpleEQAudioProcessor.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/PluginProcessor.h"
+
+#include <iostream>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <malloc.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <malloc/malloc.h>
+#endif
+
+namespace {
+    // Bytes the allocator has handed out and not had back, 0 where it can't be queried
+    std::size_t getHeapBytesInUse() {
+       #if JUCE_LINUX && defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        const auto info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+       #elif JUCE_MAC
+        malloc_statistics_t stats;
+        malloc_zone_statistics(nullptr, &stats);
+        return stats.size_in_use;
+       #else
+        return 0;
+       #endif
+    }
+
+    // Jake: Hardware cache misses of the calling thread, through perf_event_open on Linux.
+    // Unavailable elsewhere or when perf_event_paranoid doesn't allow it.
+    struct CacheMissCounter {
+        CacheMissCounter() {
+           #if JUCE_LINUX
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            fd = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter() {
+           #if JUCE_LINUX
+            if (fd >= 0)
+                close(fd);
+           #endif
+        }
+
+        bool isAvailable() const { return fd >= 0; }
+
+        void start() {
+           #if JUCE_LINUX
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+           #endif
+            return;
+        }
+
+        juce::int64 stop() {
+            long long count = 0;
+           #if JUCE_LINUX
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+                    count = 0;
+            }
+           #endif
+            return (juce::int64)count;
+        }
+
+    private:
+        int fd = -1;
+    };
+
+    // Jake: One hosted plugin with its own buffer and automation source, like a track
+    struct Instance {
+        std::unique_ptr<SimpleEQAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        juce::Random random;
+        std::vector<juce::RangedAudioParameter*> automated;
+    };
+
+    // Parameters a mix engineer rides, choices stay put so the workload stays comparable
+    const juce::StringArray automatedParameters {"Peak Freq", "Peak Gain", "Peak Quality", "Low-Cut Freq", "High-Cut Freq"};
+
+    void processInstanceBlock(Instance& instance, double automationProbability) {
+        // Hosts set automated values on the audio thread just before the block
+        if (instance.random.nextDouble() < automationProbability) {
+            auto* parameter = instance.automated[(size_t)instance.random.nextInt((int)instance.automated.size())];
+            parameter->setValue(instance.random.nextFloat());
+        }
+        instance.processor->processBlock(instance.buffer, instance.midi);
+        return;
+    }
+
+    struct RunResult {
+        double seconds = 0.0;
+        juce::int64 cacheMisses = 0;
+        bool hasCacheMisses = false;
+    };
+
+    // Jake: Each job owns a contiguous slice of the instances for the whole run
+    struct PartitionJob : juce::ThreadPoolJob {
+        PartitionJob(std::vector<Instance>& i, int first, int last, int blocks, double probability)
+            : juce::ThreadPoolJob("SimpleEQ bench partition"), instances(i), begin(first), end(last),
+              numBlocks(blocks), automationProbability(probability) {}
+
+        JobStatus runJob() override {
+            CacheMissCounter counter;
+            counter.start();
+            for (int b = 0; b < numBlocks; b++) {
+                for (int i = begin; i < end; i++) {
+                    processInstanceBlock(instances[(size_t)i], automationProbability);
+                }
+            }
+            cacheMisses = counter.stop();
+            hasCacheMisses = counter.isAvailable();
+            return jobHasFinished;
+        }
+
+        std::vector<Instance>& instances;
+        const int begin, end, numBlocks;
+        const double automationProbability;
+        juce::int64 cacheMisses = 0;
+        bool hasCacheMisses = false;
+    };
+
+    juce::String formatBytes(double bytes) {
+        if (bytes >= 1024.0 * 1024.0)
+            return juce::String(bytes / (1024.0 * 1024.0), 2) + " MiB";
+        if (bytes >= 1024.0)
+            return juce::String(bytes / 1024.0, 1) + " KiB";
+        return juce::String((int)bytes) + " B";
+    }
+
+    void printRun(const char* name, const RunResult& result, int numInstances, int numFrames, double sampleRate, int numBlocks) {
+        const auto instanceFrames = (double)numInstances * numFrames;
+        const auto realtimeFactor = (numFrames / sampleRate) / result.seconds;
+        std::cout << name << ": " << juce::String(result.seconds, 3) << " s, "
+                  << juce::String(1.0e9 * result.seconds / instanceFrames, 2) << " ns per instance frame, "
+                  << juce::String(numInstances * realtimeFactor, 0) << " instances in real time";
+        if (result.hasCacheMisses)
+            std::cout << ", " << juce::String((double)result.cacheMisses / ((double)numInstances * numBlocks), 1) << " cache misses per instance block";
+        else
+            std::cout << ", cache misses n/a";
+        std::cout << std::endl;
+        return;
+    }
+}
+
+void runBench(const juce::ArgumentList& args) {
+    const auto numInstances = args.containsOption("--instances") ? args.getValueForOption("--instances").getIntValue() : 200;
+    const auto sampleRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 48000.0;
+    const auto blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 256;
+    const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+    const auto automationProbability = args.containsOption("--automation") ? args.getValueForOption("--automation").getDoubleValue() : 0.1;
+    auto numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0;
+
+    if (numInstances <= 0 || sampleRate <= 0.0 || blockSize <= 0 || seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid --instances, --rate, --block or --seconds");
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+    numThreads = juce::jmin(numThreads, numInstances);
+
+    // The parameter state starts timers, which need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Footprint: whole instances before and after prepareToPlay. The filters themselves are the
+    // ChainFilter inside the processor object and own nothing on the heap.
+    const auto heapBeforeInstances = (double)getHeapBytesInUse();
+    std::vector<Instance> instances((size_t)numInstances);
+    for (auto& instance : instances) {
+        instance.processor = std::make_unique<SimpleEQAudioProcessor>();
+    }
+    const auto heapConstructed = (double)getHeapBytesInUse();
+
+    juce::Random seeds(1);
+    for (auto& instance : instances) {
+        instance.processor->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        instance.processor->prepareToPlay(sampleRate, blockSize);
+        instance.buffer.setSize(2, blockSize);
+        instance.midi.ensureSize(256);
+        instance.random.setSeed(seeds.nextInt64());
+        for (auto& id : automatedParameters) {
+            instance.automated.push_back(instance.processor->aptvs.getParameter(id));
+        }
+
+        // -12 dBFS noise, refreshed only here so the loop measures the plugin and not the generator
+        for (int ch = 0; ch < 2; ch++) {
+            for (int i = 0; i < blockSize; i++) {
+                instance.buffer.setSample(ch, i, 0.25f * (2.0f * instance.random.nextFloat() - 1.0f));
+            }
+        }
+    }
+    const auto heapPrepared = (double)getHeapBytesInUse();
+
+    const auto numBlocks = juce::jmax(1, (int)(seconds * sampleRate / blockSize));
+    const auto numFrames = numBlocks * blockSize;
+
+    // Serial: every instance in turn for each block, like a single audio thread
+    RunResult serial;
+    {
+        CacheMissCounter counter;
+        const auto start = juce::Time::getHighResolutionTicks();
+        counter.start();
+        for (int b = 0; b < numBlocks; b++) {
+            for (auto& instance : instances) {
+                processInstanceBlock(instance, automationProbability);
+            }
+        }
+        serial.cacheMisses = counter.stop();
+        serial.hasCacheMisses = counter.isAvailable();
+        serial.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    }
+
+    // Parallel: contiguous slices on a pool with one thread per slice
+    RunResult parallel;
+    {
+        juce::ThreadPool pool(numThreads);
+        std::vector<std::unique_ptr<PartitionJob>> jobs;
+        for (int t = 0; t < numThreads; t++) {
+            jobs.push_back(std::make_unique<PartitionJob>(instances, t * numInstances / numThreads, (t + 1) * numInstances / numThreads,
+                                                          numBlocks, automationProbability));
+        }
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (auto& job : jobs) {
+            pool.addJob(job.get(), false);
+        }
+        for (auto& job : jobs) {
+            pool.waitForJobToFinish(job.get(), -1);
+        }
+        parallel.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        for (auto& job : jobs) {
+            parallel.cacheMisses += job->cacheMisses;
+            parallel.hasCacheMisses = job->hasCacheMisses;
+        }
+    }
+
+    std::cout << numInstances << " instances, rate " << sampleRate << " Hz, block " << blockSize << ", "
+              << numFrames << " frames each, automation " << automationProbability << " per block, "
+              << numThreads << " threads" << std::endl;
+    if (heapPrepared > 0.0) {
+        std::cout << "memory per instance: " << formatBytes((heapPrepared - heapBeforeInstances) / numInstances)
+                  << " (" << formatBytes((heapConstructed - heapBeforeInstances) / numInstances) << " constructed)" << std::endl;
+        std::cout << "  ChainFilter: " << formatBytes((double)sizeof(ChainFilter))
+                  << " inside the processor, coefficients and state of both channels" << std::endl;
+        std::cout << "  processor object: " << formatBytes((double)sizeof(SimpleEQAudioProcessor))
+                  << ", the rest is the parameter state, meters and buffers" << std::endl;
+    }
+    else {
+        std::cout << "memory per instance: n/a" << std::endl;
+    }
+    printRun("serial", serial, numInstances, numFrames, sampleRate, numBlocks);
+    printRun("parallel", parallel, numInstances, numFrames, sampleRate, numBlocks);
+   #if SIMPLEEQ_INSTRUMENTATION
+    juce::uint64 audioThreadAllocations = 0;
+    for (auto& instance : instances) {
+        audioThreadAllocations += instance.processor->getStats().getSnapshot().audioThreadAllocations;
+    }
+    std::cout << "audio thread allocations: " << audioThreadAllocations << std::endl;
+   #endif
+    return;
+}
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ChainBenchCommand.cpp
+    Compares the specialised ChainFilter kernels with the stage at a time path.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/ChainFilter.h"
+
+#include <iostream>
+
+namespace {
+    // Jake: One row of the table, the layouts and designs the kernel table specialises on
+    struct ChainCase {
+        int numChannels;
+        Slope slope;
+        float peakGainInDecibels;
+    };
+
+    // Best of several runs, in nanoseconds per sample frame
+    template<typename Function>
+    double timeRuns(int numRuns, int numFrames, Function&& function) {
+        auto best = std::numeric_limits<double>::max();
+        for (int run = 0; run < numRuns; run++) {
+            const auto start = juce::Time::getHighResolutionTicks();
+            function();
+            const auto ticks = juce::Time::getHighResolutionTicks() - start;
+            best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(ticks));
+        }
+        return 1.0e9 * best / numFrames;
+    }
+
+    void fillNoise(juce::AudioBuffer<float>& buffer) {
+        juce::Random random(1);
+        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+            for (int i = 0; i < buffer.getNumSamples(); i++) {
+                buffer.setSample(ch, i, 0.25f * (2.0f * random.nextFloat() - 1.0f));
+            }
+        }
+        return;
+    }
+}
+
+void runChainBench(const juce::ArgumentList& args) {
+    const auto sampleRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 48000.0;
+    const auto blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 256;
+    const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 5.0;
+    constexpr int numRuns = 5;
+
+    if (sampleRate <= 0.0 || blockSize <= 0 || seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid --rate, --block or --seconds");
+
+    // Buffers are filtered over and over in place, keep the decaying tails out of denormal
+    // range like processBlock does
+    juce::ScopedNoDenormals noDenormals;
+    const auto numBlocks = juce::jmax(1, (int)(seconds * sampleRate / blockSize));
+    const auto numFrames = numBlocks * blockSize;
+    const std::array<ChainCase, 8> cases {{
+        {1, Slope_12, 0.0f}, {1, Slope_12, 6.0f}, {1, Slope_48, 6.0f}, {1, Slope_96, 6.0f},
+        {2, Slope_12, 0.0f}, {2, Slope_12, 6.0f}, {2, Slope_48, 6.0f}, {2, Slope_96, 6.0f},
+    }};
+
+    std::cout << "rate " << sampleRate << " Hz, block " << blockSize << ", " << numFrames << " frames, best of " << numRuns << std::endl;
+    std::cout << "channels  slope  peak   staged ns/frame  specialised ns/frame  speedup" << std::endl;
+    for (const auto& chainCase : cases) {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.0f;
+        settings.highCutFreq = 12000.0f;
+        settings.peakFreq = 1000.0f;
+        settings.peakGainInDecibels = chainCase.peakGainInDecibels;
+        settings.peakQuality = 1.0f;
+        settings.lowCutSlope = chainCase.slope;
+        settings.highCutSlope = chainCase.slope;
+
+        ChainFilter filter;
+        filter.setCoefficients(makeChainCoefficients(settings, sampleRate));
+        juce::AudioBuffer<float> buffer(chainCase.numChannels, blockSize);
+        fillNoise(buffer);
+        auto* const* channels = buffer.getArrayOfWritePointers();
+
+        // The staged path is what processBlock ran before the kernels, a neutral peak included
+        const auto stagedCost = timeRuns(numRuns, numFrames, [&] {
+            for (int b = 0; b < numBlocks; b++) {
+                for (int ch = 0; ch < chainCase.numChannels; ch++) {
+                    filter.processLowCut(ch, channels[ch], blockSize);
+                    filter.processPeak(ch, channels[ch], blockSize);
+                    filter.processHighCut(ch, channels[ch], blockSize);
+                }
+            }
+        });
+        filter.reset();
+        fillNoise(buffer);
+        const auto specialisedCost = timeRuns(numRuns, numFrames, [&] {
+            for (int b = 0; b < numBlocks; b++) {
+                filter.process(channels, chainCase.numChannels, blockSize);
+            }
+        });
+
+        std::cout << juce::String(chainCase.numChannels).paddedLeft(' ', 8) << "  "
+                  << juce::String(6 * ((int)chainCase.slope + 1)).paddedLeft(' ', 5) << "  "
+                  << (filter.isPeakActive() ? "on " : "off") << "  "
+                  << juce::String(stagedCost, 2).paddedLeft(' ', 15) << "  "
+                  << juce::String(specialisedCost, 2).paddedLeft(' ', 20) << "  "
+                  << juce::String(stagedCost / specialisedCost, 2).paddedLeft(' ', 6) << "x" << std::endl;
+    }
+    return;
+}
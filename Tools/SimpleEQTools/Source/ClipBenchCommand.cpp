@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    ClipBenchCommand.cpp
+    Aliasing and cost of the ADAA soft clipper against the plain curve.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/SoftClipper.h"
+
+#include <iostream>
+
+namespace {
+    constexpr int spectrumOrder = 16;
+    constexpr int spectrumSize = 1 << spectrumOrder;
+    constexpr int harmonicHalfWidth = 6;    // bins on each side of a harmonic, the window's main lobe and then some
+
+    // Best of several runs, in nanoseconds per sample
+    template<typename Function>
+    double timeRuns(int numRuns, int numSamples, Function&& function) {
+        auto best = std::numeric_limits<double>::max();
+        for (int run = 0; run < numRuns; run++) {
+            const auto start = juce::Time::getHighResolutionTicks();
+            function();
+            const auto ticks = juce::Time::getHighResolutionTicks() - start;
+            best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(ticks));
+        }
+        return 1.0e9 * best / numSamples;
+    }
+
+    // Power outside the harmonics of frequency below Nyquist, in dB of the total. Everything
+    // there was folded back from above Nyquist.
+    double getAliasingDecibels(const std::vector<float>& output, double frequency, double sampleRate) {
+        std::vector<float> spectrum(2 * spectrumSize);
+        std::copy(output.end() - spectrumSize, output.end(), spectrum.begin());
+        juce::dsp::WindowingFunction<float> window((size_t)spectrumSize, juce::dsp::WindowingFunction<float>::blackmanHarris, false);
+        window.multiplyWithWindowingTable(spectrum.data(), (size_t)spectrumSize);
+        juce::dsp::FFT(spectrumOrder).performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+        std::vector<bool> isHarmonic(spectrumSize / 2 + 1, false);
+        for (int k = 1; k * frequency < 0.5 * sampleRate; k++) {
+            const auto centre = juce::roundToInt(k * frequency * spectrumSize / sampleRate);
+            for (auto bin = juce::jmax(0, centre - harmonicHalfWidth); bin <= juce::jmin(spectrumSize / 2, centre + harmonicHalfWidth); bin++) {
+                isHarmonic[(size_t)bin] = true;
+            }
+        }
+
+        double total = 0.0, aliased = 0.0;
+        for (int bin = 1; bin <= spectrumSize / 2; bin++) {
+            const auto power = (double)spectrum[(size_t)bin] * (double)spectrum[(size_t)bin];
+            total += power;
+            aliased += isHarmonic[(size_t)bin] ? 0.0 : power;
+        }
+        return 10.0 * std::log10(juce::jmax(aliased, 1.0e-30) / juce::jmax(total, 1.0e-30));
+    }
+}
+
+void runClipBench(const juce::ArgumentList& args) {
+    const auto sampleRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 48000.0;
+    const auto blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 512;
+    const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 5.0;
+    constexpr int numRuns = 5;
+
+    if (sampleRate <= 0.0 || blockSize <= 0 || seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid --rate, --block or --seconds");
+
+    // Sines a little off round frequencies, so aliases don't land on harmonics. The first
+    // samples settle the kernel and are left out of the spectrum.
+    const auto length = spectrumSize + 4096;
+    std::vector<float> input((size_t)length), plain((size_t)length), adaa((size_t)length), scratch((size_t)length);
+    std::cout << "rate " << sampleRate << " Hz, aliasing in dB of the output power" << std::endl;
+    std::cout << "frequency   gain   plain    ADAA   lower by" << std::endl;
+    for (const auto frequency : {1003.0, 2503.0, 5003.0, 10007.0}) {
+        if (frequency >= 0.5 * sampleRate)
+            continue;
+        for (const auto gain : {1.0, 2.0, 4.0}) {
+            for (int i = 0; i < length; i++) {
+                input[(size_t)i] = (float)(gain * std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+                plain[(size_t)i] = softClip(input[(size_t)i]);
+            }
+            adaa = input;
+            auto previous = 0.0f;
+            processSoftClip(adaa.data(), previous, scratch.data(), length);
+
+            const auto plainAliasing = getAliasingDecibels(plain, frequency, sampleRate);
+            const auto adaaAliasing = getAliasingDecibels(adaa, frequency, sampleRate);
+            std::cout << juce::String(frequency, 0).paddedLeft(' ', 9) << "  "
+                      << juce::String(gain, 1).paddedLeft(' ', 5) << "  "
+                      << juce::String(plainAliasing, 1).paddedLeft(' ', 6) << "  "
+                      << juce::String(adaaAliasing, 1).paddedLeft(' ', 6) << "  "
+                      << juce::String(plainAliasing - adaaAliasing, 1).paddedLeft(' ', 9) << std::endl;
+        }
+    }
+
+    // Cost on a sine driven 10 dB past the knee, so every branch of the kernel is taken
+    const auto numBlocks = juce::jmax(1, (int)(seconds * sampleRate / blockSize));
+    const auto numSamples = numBlocks * blockSize;
+    std::vector<float> source((size_t)blockSize), block((size_t)blockSize);
+    for (int i = 0; i < blockSize; i++) {
+        source[(size_t)i] = 4.5f * (float)std::sin(juce::MathConstants<double>::twoPi * 997.0 * i / sampleRate);
+    }
+    auto previous = 0.0f;
+    const auto plainCost = timeRuns(numRuns, numSamples, [&] {
+        for (int b = 0; b < numBlocks; b++) {
+            for (int i = 0; i < blockSize; i++) {
+                block[(size_t)i] = softClip(source[(size_t)i]);
+            }
+        }
+    });
+    const auto adaaCost = timeRuns(numRuns, numSamples, [&] {
+        for (int b = 0; b < numBlocks; b++) {
+            std::copy(source.begin(), source.end(), block.begin());
+            processSoftClip(block.data(), previous, scratch.data(), blockSize);
+        }
+    });
+    std::cout << "block " << blockSize << ", " << numSamples << " samples, best of " << numRuns << std::endl;
+    std::cout << "plain curve: " << juce::String(plainCost, 2) << " ns/sample" << std::endl;
+    std::cout << "ADAA kernel: " << juce::String(adaaCost, 2) << " ns/sample, including a copy of the block" << std::endl;
+    return;
+}
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    Commands.h
+    Sub-commands of the SimpleEQTools command line utility.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Jake: analyse [options] <state files...>
+void runAnalyse(const juce::ArgumentList& args);
+
+// Jake: meterbench [--rate=48000] [--block=512] [--seconds=10]
+void runMeterBench(const juce::ArgumentList& args);
+
+// Jake: bench [--instances=200] [--rate=48000] [--block=256] [--seconds=2] [--automation=0.1] [--threads=0]
+void runBench(const juce::ArgumentList& args);
+
+// Jake: chainbench [--rate=48000] [--block=256] [--seconds=5]
+void runChainBench(const juce::ArgumentList& args);
+
+// Jake: clipbench [--rate=48000] [--block=512] [--seconds=5]
+void runClipBench(const juce::ArgumentList& args);
+
+// Jake: match [--rate=48000] [--points=96] <input file> <reference file>
+void runMatch(const juce::ArgumentList& args);
+
+// Jake: trace2json [--output=file.json] <trace file>
+void runTraceToJson(const juce::ArgumentList& args);
+
+// Jake: test [--category=SimpleEQ] [--golden=file] [--write-golden=file]
+void runTests(const juce::ArgumentList& args);
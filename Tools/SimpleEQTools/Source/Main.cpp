@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Entry point of SimpleEQTools, command line utilities for SimpleEQ.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Commands.h"
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "SimpleEQTools, command line utilities for SimpleEQ", true);
+    
+    app.addCommand ({ "analyse",
+                      "analyse [--rate=48000] [--points=512] [--threads=0] [--boost-threshold=6] [--vocal-range=300:3400] [--cut-threshold=-3] [--csv=dir] <state files...>",
+                      "Reports boosts and vocal range cuts for saved SimpleEQ states",
+                      "Loads each state blob (as written by getStateInformation, or its XML form), "
+                      "evaluates magnitude, phase and group delay of the designed chain on a log frequency "
+                      "grid and prints one line per file. Files whose response exceeds --boost-threshold "
+                      "are flagged BOOST, files that cut below --cut-threshold inside --vocal-range are "
+                      "flagged VOCAL_CUT. With --csv the full response of every file is written as CSV.",
+                      [] (const juce::ArgumentList& args) { runAnalyse (args); } });
+    
+    app.addCommand ({ "meterbench",
+                      "meterbench [--rate=48000] [--block=512] [--seconds=10]",
+                      "Times the level/loudness meter against the filter chain",
+                      "Runs stereo noise through the default filter chain, the worst case chain (96 dB/Oct "
+                      "cuts and the peak) and an enabled LevelMeter, and prints the best of five runs of "
+                      "each in nanoseconds per stereo frame.",
+                      [] (const juce::ArgumentList& args) { runMeterBench (args); } });
+    
+    app.addCommand ({ "bench",
+                      "bench [--instances=200] [--rate=48000] [--block=256] [--seconds=2] [--automation=0.1] [--threads=0]",
+                      "Hosts many SimpleEQAudioProcessor instances and reports throughput and footprint",
+                      "Creates --instances processors, prepares them, and processes --seconds of stereo noise "
+                      "through all of them, first serially on one thread and then split across a thread pool "
+                      "(--threads, 0 for one per CPU). Before each block an instance moves one of its continuous "
+                      "parameters with probability --automation. Prints heap use per instance, time per instance "
+                      "frame, how many instances would run in real time and hardware cache misses per block "
+                      "where perf events are available.",
+                      [] (const juce::ArgumentList& args) { runBench (args); } });
+    
+    app.addCommand ({ "chainbench",
+                      "chainbench [--rate=48000] [--block=256] [--seconds=5]",
+                      "Times the specialised filter kernels against the stage at a time path",
+                      "Runs noise through a ChainFilter for mono and stereo, 12 to 96 dB/Oct cuts and a "
+                      "neutral or active peak, once one stage and one channel at a time and once through "
+                      "the kernel specialised for that layout and design. Prints the best of five runs of "
+                      "each in nanoseconds per frame and the speedup.",
+                      [] (const juce::ArgumentList& args) { runChainBench (args); } });
+
+    app.addCommand ({ "clipbench",
+                      "clipbench [--rate=48000] [--block=512] [--seconds=5]",
+                      "Measures aliasing and cost of the soft clipper",
+                      "Drives sines at 1 to 10 kHz into the soft clip curve, plain and antiderivative "
+                      "antialiased, and prints the power outside the harmonics in dB of the output for "
+                      "each. Then times both on a sine past the knee and prints the best of five runs "
+                      "in nanoseconds per sample.",
+                      [] (const juce::ArgumentList& args) { runClipBench (args); } });
+    
+    app.addCommand ({ "match",
+                      "match [--rate=48000] [--points=96] <input file> <reference file>",
+                      "Fits the chain to match a reference recording's tonal balance",
+                      "Averages the long-term spectrum of both recordings, fits low cut, peak and high cut "
+                      "to the reference minus the input on a log grid of --points frequencies at --rate, "
+                      "overall level left out, and prints the fitted settings, the RMS error left and the "
+                      "time the fit took. Slopes and cut types stay at their defaults.",
+                      [] (const juce::ArgumentList& args) { runMatch (args); } });
+    
+    app.addCommand ({ "trace2json",
+                      "trace2json [--output=file.json] <trace file>",
+                      "Converts a SimpleEQ trace to Chrome trace-event JSON",
+                      "Reads a trace written by the plugin (SIMPLEEQ_TRACE_DIR) or the headless rig (--trace) and "
+                      "writes it as trace-event JSON for Perfetto or chrome://tracing, next to the trace unless "
+                      "--output is given. Blocks and coefficient rebuilds become slices on the audio thread, "
+                      "parameters become counters and suspected xruns instant events. Prints a summary with the "
+                      "highest block load and the most parameter changes in one second.",
+                      [] (const juce::ArgumentList& args) { runTraceToJson (args); } });
+    
+    app.addCommand ({ "test",
+                      "test [--category=SimpleEQ] [--golden=file] [--write-golden=file]",
+                      "Runs the SimpleEQ unit tests",
+                      "Runs the unit tests of --category and exits with code 1 when any check fails. The golden "
+                      "output test renders impulses, sweeps and noise through the processor for every slope, cut "
+                      "type and parameter extreme at 44.1 to 192 kHz and compares them with the built in "
+                      "GoldenOutput.csv, or with --golden. --write-golden renders the same cases into a new file "
+                      "instead of testing.",
+                      [] (const juce::ArgumentList& args) { runTests (args); } });
+    
+    return app.findAndRunCommand (argc, argv);
+}
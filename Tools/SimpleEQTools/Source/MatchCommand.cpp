@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    MatchCommand.cpp
+    Fits the chain to move one recording's tonal balance towards another's.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/MatchEQ.h"
+
+#include <iostream>
+
+void runMatch(const juce::ArgumentList& args) {
+    const auto sampleRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 48000.0;
+    const auto numPoints = args.containsOption("--points") ? args.getValueForOption("--points").getIntValue() : 96;
+    if (sampleRate <= 0.0 || numPoints < 2)
+        juce::ConsoleApplication::fail("Invalid --rate or --points");
+    
+    juce::Array<juce::File> files;
+    for (int i = 1; i < args.size(); i++) {
+        if (!args[i].isOption())
+            files.add(args[i].resolveAsFile());
+    }
+    if (files.size() != 2)
+        juce::ConsoleApplication::fail("Give the input file and the reference file");
+    
+    AveragedSpectrum input, reference;
+    if (!analyseAudioFile(files[0], input))
+        juce::ConsoleApplication::fail("Can't read " + files[0].getFullPathName());
+    if (!analyseAudioFile(files[1], reference))
+        juce::ConsoleApplication::fail("Can't read " + files[1].getFullPathName());
+    
+    // Starts from the parameter defaults, the same way a fresh instance would match
+    ChainSettings current;
+    current.lowCutFreq = 20.0f;
+    current.highCutFreq = 20000.0f;
+    current.peakFreq = 750.0f;
+    current.peakQuality = 1.0f;
+    
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto fit = fitChainSettings(makeMatchTarget(input, reference, numPoints), current, sampleRate);
+    const auto milliseconds = 1000.0 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    
+    std::cout << "input " << juce::String(input.getSeconds(), 1) << " s, reference " << juce::String(reference.getSeconds(), 1) << " s" << std::endl;
+    std::cout << "Low-Cut Freq   " << juce::String(fit.settings.lowCutFreq, 1) << " Hz" << std::endl;
+    std::cout << "High-Cut Freq  " << juce::String(fit.settings.highCutFreq, 1) << " Hz" << std::endl;
+    std::cout << "Peak Freq      " << juce::String(fit.settings.peakFreq, 1) << " Hz" << std::endl;
+    std::cout << "Peak Gain      " << juce::String(fit.settings.peakGainInDecibels, 2) << " dB" << std::endl;
+    std::cout << "Peak Quality   " << juce::String(fit.settings.peakQuality, 2) << std::endl;
+    std::cout << "rms error " << juce::String(fit.rmsErrorDecibels, 2) << " dB, fitted in " << juce::String(milliseconds, 1) << " ms" << std::endl;
+    return;
+}
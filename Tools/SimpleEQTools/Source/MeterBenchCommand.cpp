@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    MeterBenchCommand.cpp
+    Measures the cost of the metering tap against the filter chain.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/ChainFilter.h"
+#include "../../../Source/LevelMeter.h"
+
+#include <iostream>
+
+namespace {
+    // Best of several runs, in nanoseconds per sample frame
+    template<typename Function>
+    double timeRuns(int numRuns, int numFrames, Function&& function) {
+        auto best = std::numeric_limits<double>::max();
+        for (int run = 0; run < numRuns; run++) {
+            const auto start = juce::Time::getHighResolutionTicks();
+            function();
+            const auto ticks = juce::Time::getHighResolutionTicks() - start;
+            best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(ticks));
+        }
+        return 1.0e9 * best / numFrames;
+    }
+}
+
+void runMeterBench(const juce::ArgumentList& args) {
+    const auto sampleRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 48000.0;
+    const auto blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 512;
+    const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 10.0;
+    constexpr int numRuns = 5;
+    
+    if (sampleRate <= 0.0 || blockSize <= 0 || seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid --rate, --block or --seconds");
+    
+    // Stereo noise at -12 dBFS. The chain filters a fresh copy of it every block, its own output
+    // fed back in would grow through the peak until it overflows. Steady noise is also the worst
+    // case for the meter, nearly every block could raise the true-peak hold.
+    const auto numBlocks = juce::jmax(1, (int)(seconds * sampleRate / blockSize));
+    juce::AudioBuffer<float> buffer(2, blockSize), filtered(2, blockSize);
+    juce::Random random(1);
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+        for (int i = 0; i < blockSize; i++) {
+            buffer.setSample(ch, i, 0.25f * (2.0f * random.nextFloat() - 1.0f));
+        }
+    }
+    
+    // The parameter defaults, 12 dB/Oct cuts at 20 Hz and 20 kHz with the peak at 0 dB, and the
+    // worst case of 96 dB/Oct on both cuts plus a boosting peak
+    ChainSettings defaultSettings;
+    defaultSettings.lowCutFreq = 20.0f;
+    defaultSettings.highCutFreq = 20000.0f;
+    defaultSettings.peakFreq = 750.0f;
+    defaultSettings.peakGainInDecibels = 0.0f;
+    defaultSettings.peakQuality = 1.0f;
+    
+    ChainSettings worstSettings;
+    worstSettings.lowCutFreq = 80.0f;
+    worstSettings.highCutFreq = 12000.0f;
+    worstSettings.peakFreq = 1000.0f;
+    worstSettings.peakGainInDecibels = 6.0f;
+    worstSettings.peakQuality = 1.0f;
+    worstSettings.lowCutSlope = Slope_96;
+    worstSettings.highCutSlope = Slope_96;
+    
+    // Both chains run through the kernels processBlock uses
+    const auto numFrames = numBlocks * blockSize;
+    const auto timeChain = [&] (const ChainSettings& settings) {
+        ChainFilter chain;
+        chain.setCoefficients(makeChainCoefficients(settings, sampleRate));
+        return timeRuns(numRuns, numFrames, [&] {
+            for (int b = 0; b < numBlocks; b++) {
+                for (int ch = 0; ch < 2; ch++) {
+                    filtered.copyFrom(ch, 0, buffer, ch, 0, blockSize);
+                }
+                chain.process(filtered.getArrayOfWritePointers(), 2, blockSize);
+            }
+        });
+    };
+    const auto defaultCost = timeChain(defaultSettings);
+    const auto worstCost = timeChain(worstSettings);
+    
+    LevelMeter meter;
+    meter.prepare(sampleRate, blockSize, 2);
+    meter.setEnabled(true);
+    const auto meterCost = timeRuns(numRuns, numFrames, [&] {
+        for (int b = 0; b < numBlocks; b++) {
+            meter.process(buffer);
+        }
+    });
+    
+    const auto readings = meter.getReadings();
+    std::cout << "rate " << sampleRate << " Hz, block " << blockSize << ", " << numFrames << " stereo frames, best of " << numRuns << std::endl;
+    std::cout << "default chain:    " << juce::String(defaultCost, 2).paddedLeft(' ', 7) << " ns/frame, including a copy of the block" << std::endl;
+    std::cout << "worst case chain: " << juce::String(worstCost, 2).paddedLeft(' ', 7) << " ns/frame, including a copy of the block" << std::endl;
+    std::cout << "one meter tap:    " << juce::String(meterCost, 2).paddedLeft(' ', 7) << " ns/frame, "
+              << juce::String(100.0 * meterCost / defaultCost, 1) << "% of the default chain, "
+              << juce::String(100.0 * meterCost / worstCost, 1) << "% of the worst case" << std::endl;
+    std::cout << "processBlock runs an input and an output tap while the editor shows them, none while it is closed" << std::endl;
+    std::cout << "short-term loudness " << readings.shortTermLoudness << " LUFS" << std::endl;
+    return;
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    TestCommand.cpp
+    Runs the SimpleEQ unit tests, or writes new golden data.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../Tests/ProcessorRender.h"
+
+#include <iostream>
+
+void runTests(const juce::ArgumentList& args) {
+    // The processors' parameter state starts timers, which need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (args.containsOption("--write-golden")) {
+        const auto file = args.getFileForOption("--write-golden");
+        if (!file.replaceWithText(makeGoldenFile(), false, false, "\r\n"))
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+        std::cout << "wrote " << file.getFullPathName() << std::endl;
+        return;
+    }
+
+    if (args.containsOption("--golden")) {
+        const auto file = args.getExistingFileForOption("--golden");
+        setGoldenFile(file);
+    }
+
+    const auto category = args.containsOption("--category") ? args.getValueForOption("--category") : juce::String("SimpleEQ");
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory(category);
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); i++) {
+        numFailures += runner.getResult(i)->failures;
+    }
+    if (runner.getNumResults() == 0)
+        juce::ConsoleApplication::fail("No tests in category " + category);
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " checks failed", 1);
+    return;
+}
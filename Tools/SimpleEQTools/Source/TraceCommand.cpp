@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    TraceCommand.cpp
+    Converts a SimpleEQ trace to Chrome trace-event JSON and summarises it.
+
+  ==============================================================================
+*/
+
+#include "Commands.h"
+#include "../../../Source/TraceRecorder.h"
+
+#include <array>
+#include <iostream>
+#include <map>
+
+void runTraceToJson(const juce::ArgumentList& args) {
+    juce::Array<juce::File> files;
+    for (int i = 1; i < args.size(); i++) {
+        if (!args[i].isOption())
+            files.add(args[i].resolveAsFile());
+    }
+    if (files.size() != 1)
+        juce::ConsoleApplication::fail("Give one trace file");
+    
+    const auto trace = readTraceFile(files[0]);
+    if (!trace.has_value())
+        juce::ConsoleApplication::fail("Not a SimpleEQ trace: " + files[0].getFullPathName());
+    
+    const auto output = args.containsOption("--output") ? args.getFileForOption("--output") : files[0].withFileExtension("json");
+    juce::FileOutputStream json(output);
+    if (!json.openedOk() || !json.setPosition(0) || !json.truncate().wasOk())
+        juce::ConsoleApplication::fail("Can't write " + output.getFullPathName());
+    writeChromeTrace(*trace, json);
+    json.flush();
+    
+    // Enough to see whether the stutters line up with the automation
+    std::array<int, NumTraceEventTypes> counts {};
+    std::map<juce::int64, int> changesPerSecond;
+    float maxLoad = 0.0f;
+    juce::int64 lastTicks = 0;
+    juce::uint64 numDropped = 0;
+    for (const auto& record : trace->records) {
+        if (record.type >= NumTraceEventTypes)
+            continue;
+        counts[record.type]++;
+        lastTicks = juce::jmax(lastTicks, record.ticks);
+        if (record.type == TraceEvent_Block)
+            maxLoad = juce::jmax(maxLoad, record.value);
+        else if (record.type == TraceEvent_ParameterChange)
+            changesPerSecond[record.ticks / trace->ticksPerSecond]++;
+        else if (record.type == TraceEvent_RecordsDropped)
+            numDropped += record.count;
+    }
+    int busiestSecond = 0;
+    for (const auto& [second, changes] : changesPerSecond) {
+        busiestSecond = juce::jmax(busiestSecond, changes);
+    }
+    
+    std::cout << "trace " << juce::String((double)lastTicks / (double)trace->ticksPerSecond, 2) << " s, " << (int)trace->records.size() << " records" << std::endl;
+    std::cout << "blocks " << counts[TraceEvent_Block] << ", max load " << juce::String(100.0f * maxLoad, 1) << " %" << std::endl;
+    std::cout << "coefficient rebuilds " << counts[TraceEvent_CoefficientRebuild] << std::endl;
+    std::cout << "parameter changes " << counts[TraceEvent_ParameterChange] << ", at most " << busiestSecond << " in one second" << std::endl;
+    std::cout << "suspected xruns " << counts[TraceEvent_XrunSuspected] << std::endl;
+    if (numDropped > 0)
+        std::cout << "dropped records " << (juce::int64)numDropped << ", the ring was full" << std::endl;
+    std::cout << "wrote " << output.getFullPathName() << std::endl;
+    return;
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    GoldenOutputTest.cpp
+    Compares what the processor makes of the test signals with GoldenOutput.csv.
+
+  ==============================================================================
+*/
+
+#include "ProcessorRender.h"
+
+namespace {
+    constexpr int maxReportsPerCase = 4;
+
+    class GoldenOutputTest : public juce::UnitTest {
+    public:
+        GoldenOutputTest() : juce::UnitTest("Golden output", "SimpleEQ") {}
+
+        void runTest() override {
+            beginTest("Golden data");
+            const auto golden = parseGoldenFile(loadGoldenFile());
+            const auto cases = makeGoldenCases();
+            expectEquals((int)golden.size(), (int)cases.size(), "cases in the golden data");
+
+            for (const auto& goldenCase : cases) {
+                beginTest(goldenCase.name);
+                const auto found = golden.find(goldenCase.name);
+                if (found == golden.end()) {
+                    expect(false, goldenCase.name + " is missing from the golden data");
+                    continue;
+                }
+                // The fingerprint, then the rounding noise of the build that wrote it
+                const auto& expected = found->second;
+                if (expected.size() != (size_t)(2 * GoldenFingerprint::numValues)) {
+                    expect(false, goldenCase.name + " has " + juce::String((int)expected.size()) + " values");
+                    continue;
+                }
+
+                // Only the first few differences of a case, one wrong filter tends to move all of them
+                const auto actual = GoldenFingerprint::make(renderGoldenCase(goldenCase));
+                int numReported = 0;
+                for (int i = 0; i < GoldenFingerprint::numValues && numReported < maxReportsPerCase; i++) {
+                    if (GoldenFingerprint::matches(i, expected[(size_t)i], expected[(size_t)(GoldenFingerprint::numValues + i)], actual[(size_t)i]))
+                        continue;
+                    expect(false, goldenCase.name + " value " + juce::String(i) + ": expected "
+                                  + juce::String(expected[(size_t)i], 6) + ", got " + juce::String(actual[(size_t)i], 6));
+                    numReported++;
+                }
+            }
+            return;
+        }
+    };
+
+    static GoldenOutputTest goldenOutputTest;
+}
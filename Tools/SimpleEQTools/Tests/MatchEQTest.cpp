@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    MatchEQTest.cpp
+    Loading reference files into the Match EQ analyser.
+
+  ==============================================================================
+*/
+
+#include "../../../Source/MatchEQ.h"
+
+namespace {
+    constexpr double fileSampleRate = 48000.0;
+    constexpr double fileSeconds = 2.0;
+    constexpr double toneFrequency = 1000.0;
+    constexpr int loadTimeoutMilliseconds = 10000;
+
+    // Mono 16 bit WAV of a tone at -6 dBFS
+    bool writeToneFile(const juce::File& file) {
+        file.deleteFile();
+        auto stream = file.createOutputStream();
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), fileSampleRate, 1, 16, {}, 0));
+        if (writer == nullptr)
+            return false;
+        stream.release();   // the writer owns it now
+
+        juce::AudioBuffer<float> tone(1, (int)(fileSeconds * fileSampleRate));
+        for (int i = 0; i < tone.getNumSamples(); i++) {
+            tone.setSample(0, i, 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi * toneFrequency * i / fileSampleRate));
+        }
+        return writer->writeFromAudioSampleBuffer(tone, 0, tone.getNumSamples());
+    }
+
+    class MatchEQTest : public juce::UnitTest {
+    public:
+        MatchEQTest() : juce::UnitTest("Match EQ", "SimpleEQ") {}
+
+        void runTest() override {
+            const auto file = juce::File::createTempFile(".wav");
+            expect(writeToneFile(file), "writing the tone file");
+
+            // The way the analyser's worker publishes a loaded file, once per load
+            beginTest("Spectrum swapped after every load");
+            {
+                AveragedSpectrum loading, published;
+                for (int load = 0; load < 3; load++) {
+                    expect(analyseAudioFile(file, loading));
+                    published.swapAccumulated(loading);
+                    expectWithinAbsoluteError(published.getSeconds(), fileSeconds, 0.1);
+
+                    const auto decibels = published.getDecibels({250.0, toneFrequency, 4000.0});
+                    expectGreaterThan(decibels[1], decibels[0] + 40.0);
+                    expectGreaterThan(decibels[1], decibels[2] + 40.0);
+                }
+            }
+
+            beginTest("Reference file loaded twice");
+            {
+                MatchAnalyser analyser;
+                analyser.setSource(MatchSource_File);
+                for (int load = 0; load < 2; load++) {
+                    analyser.loadReferenceFile(file);
+                    const auto start = juce::Time::getMillisecondCounter();
+                    while (analyser.isLoadingFile() && juce::Time::getMillisecondCounter() - start < (juce::uint32)loadTimeoutMilliseconds) {
+                        juce::Thread::sleep(10);
+                    }
+                    expect(!analyser.isLoadingFile(), "load " + juce::String(load + 1) + " finished");
+                    expectEquals(analyser.getReferenceFileName(), file.getFileName());
+                    expectWithinAbsoluteError(analyser.getReferenceSeconds(), fileSeconds, 0.1);
+                }
+            }
+
+            file.deleteFile();
+            return;
+        }
+    };
+
+    static MatchEQTest matchEQTest;
+}
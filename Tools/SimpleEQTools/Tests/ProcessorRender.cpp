@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    ProcessorRender.cpp
+    Renders the golden test signals through SimpleEQAudioProcessor.
+
+  ==============================================================================
+*/
+
+#include "ProcessorRender.h"
+
+namespace {
+    juce::File goldenFileOverride;
+
+    // Transposed direct form II as in ChainFilter, in double precision
+    void processInDouble(const BiquadCoefficients& c, std::vector<double>& data) {
+        double z0 = 0.0, z1 = 0.0;
+        for (auto& sample : data) {
+            const auto x = sample;
+            const auto y = c.b0 * x + z0;
+            z0 = c.b1 * x - c.a1 * y + z1;
+            z1 = c.b2 * x - c.a2 * y;
+            sample = y;
+        }
+        return;
+    }
+}
+
+void setChainParameters(SimpleEQAudioProcessor& processor, const ChainSettings& settings) {
+    const std::array<std::pair<const char*, float>, 9> values {{
+        {"Low-Cut Freq", settings.lowCutFreq},
+        {"High-Cut Freq", settings.highCutFreq},
+        {"Peak Freq", settings.peakFreq},
+        {"Peak Gain", settings.peakGainInDecibels},
+        {"Peak Quality", settings.peakQuality},
+        {"Low-Cut Slope", (float)settings.lowCutSlope},
+        {"High-Cut Slope", (float)settings.highCutSlope},
+        {"Low-Cut Type", (float)settings.lowCutType},
+        {"High-Cut Type", (float)settings.highCutType},
+    }};
+
+    for (const auto& [id, value] : values) {
+        auto* parameter = processor.aptvs.getParameter(id);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+    return;
+}
+
+
+RenderedSignal renderTestSignal(const GoldenCase& goldenCase, TestSignal signal) {
+    SimpleEQAudioProcessor processor;
+    setChainParameters(processor, goldenCase.settings);
+    processor.setPlayConfigDetails(2, 2, goldenCase.sampleRate, renderBlockSize);
+    processor.prepareToPlay(goldenCase.sampleRate, renderBlockSize);
+
+    const auto length = getTestSignalLength(signal, goldenCase.sampleRate);
+    RenderedSignal output;
+    for (int ch = 0; ch < 2; ch++) {
+        output[(size_t)ch].resize((size_t)length);
+        makeTestSignal(signal, ch, goldenCase.sampleRate, output[(size_t)ch].data(), length);
+    }
+
+    juce::AudioBuffer<float> buffer(2, renderBlockSize);
+    juce::MidiBuffer midi;
+    for (int start = 0; start < length; start += renderBlockSize) {
+        const auto numSamples = juce::jmin(renderBlockSize, length - start);
+        buffer.setSize(2, numSamples, false, false, true);
+        for (int ch = 0; ch < 2; ch++) {
+            buffer.copyFrom(ch, 0, output[(size_t)ch].data() + start, numSamples);
+        }
+        processor.processBlock(buffer, midi);
+        for (int ch = 0; ch < 2; ch++) {
+            juce::FloatVectorOperations::copy(output[(size_t)ch].data() + start, buffer.getReadPointer(ch), numSamples);
+        }
+    }
+    processor.releaseResources();
+    return output;
+}
+
+
+RenderedSignals renderGoldenCase(const GoldenCase& goldenCase) {
+    RenderedSignals rendered;
+    for (int signal = 0; signal < NumTestSignals; signal++) {
+        rendered[(size_t)signal] = renderTestSignal(goldenCase, (TestSignal)signal);
+    }
+    return rendered;
+}
+
+
+RenderedSignals getRoundingNoise(const GoldenCase& goldenCase, const RenderedSignals& rendered) {
+    // The parameters snap the case's settings, the reference uses what the processor ended up with
+    SimpleEQAudioProcessor processor;
+    setChainParameters(processor, goldenCase.settings);
+    const auto coefficients = makeChainCoefficients(getChainSettings(processor.aptvs), goldenCase.sampleRate);
+
+    RenderedSignals noise;
+    for (int signal = 0; signal < NumTestSignals; signal++) {
+        const auto length = getTestSignalLength((TestSignal)signal, goldenCase.sampleRate);
+        for (int ch = 0; ch < 2; ch++) {
+            std::vector<float> input((size_t)length);
+            makeTestSignal((TestSignal)signal, ch, goldenCase.sampleRate, input.data(), length);
+            std::vector<double> reference(input.begin(), input.end());
+            for (int s = 0; s < coefficients.lowCut.numSections; s++) {
+                processInDouble(coefficients.lowCut[s], reference);
+            }
+            processInDouble(coefficients.peak, reference);
+            for (int s = 0; s < coefficients.highCut.numSections; s++) {
+                processInDouble(coefficients.highCut[s], reference);
+            }
+
+            const auto& output = rendered[(size_t)signal][(size_t)ch];
+            auto& difference = noise[(size_t)signal][(size_t)ch];
+            difference.resize((size_t)length);
+            for (int i = 0; i < length; i++) {
+                difference[(size_t)i] = (float)((double)output[(size_t)i] - reference[(size_t)i]);
+            }
+        }
+    }
+    return noise;
+}
+
+
+juce::String makeGoldenFile() {
+    juce::String text;
+    text << "# SimpleEQ golden output, one line per case of makeGoldenCases(): name, the values of GoldenFingerprint, then\r\n";
+    text << "# the same values of its rounding noise (the output minus a double precision render of the same coefficients)\r\n";
+    text << "# Regenerate with SimpleEQTools test --write-golden=<file> after an intended change of the output\r\n";
+    for (const auto& goldenCase : makeGoldenCases()) {
+        const auto rendered = renderGoldenCase(goldenCase);
+        text << formatGoldenLine(goldenCase.name, GoldenFingerprint::make(rendered),
+                                 GoldenFingerprint::make(getRoundingNoise(goldenCase, rendered))) << "\r\n";
+    }
+    return text;
+}
+
+
+void setGoldenFile(const juce::File& file) {
+    goldenFileOverride = file;
+    return;
+}
+
+
+juce::String loadGoldenFile() {
+    if (goldenFileOverride != juce::File())
+        return goldenFileOverride.loadFileAsString();
+    return juce::String::fromUTF8(BinaryData::GoldenOutput_csv, BinaryData::GoldenOutput_csvSize);
+}
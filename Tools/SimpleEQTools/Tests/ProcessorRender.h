@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    ProcessorRender.h
+    Renders the golden test signals through SimpleEQAudioProcessor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestSignals.h"
+#include "../../../Source/PluginProcessor.h"
+
+
+// Jake: Sets the chain parameters the way a host does, so the raw values the audio thread reads
+// are updated too. Values snap to the parameters' intervals.
+void setChainParameters(SimpleEQAudioProcessor& processor, const ChainSettings& settings);
+
+// Jake: A test signal through a freshly prepared stereo processor at the case's rate, in blocks of
+// renderBlockSize, so every signal starts from silence
+constexpr int renderBlockSize = 512;
+RenderedSignal renderTestSignal(const GoldenCase& goldenCase, TestSignal signal);
+RenderedSignals renderGoldenCase(const GoldenCase& goldenCase);
+
+// Jake: What a render of the case differs by from the same signals through the coefficients the
+// processor designed for it, run in double precision. That is the float rounding noise of this build.
+RenderedSignals getRoundingNoise(const GoldenCase& goldenCase, const RenderedSignals& rendered);
+
+// Jake: GoldenOutput.csv contents for the current build, every case of makeGoldenCases()
+juce::String makeGoldenFile();
+
+// Jake: Golden data the tests compare with, the GoldenOutput.csv built into the tools unless
+// another file was set, such as one written before a change to compare the change with.
+void setGoldenFile(const juce::File& file);
+juce::String loadGoldenFile();
@@ -0,0 +1,252 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Catches allocations, locks and system calls on a thread that must stay
+    real-time safe.
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+#if JUCE_LINUX && defined(__GLIBC__)
+ #include <atomic>
+ #include <cstdarg>
+ #include <dlfcn.h>
+ #include <fcntl.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+
+namespace {
+    // Trivial, so reading it from malloc never runs a constructor or allocates itself
+    struct ThreadCheck {
+        bool active;
+        RealtimeViolations violations;
+    };
+    thread_local ThreadCheck threadCheck {};
+
+    enum ViolationKind { Violation_Allocation, Violation_Lock, Violation_SystemCall };
+
+    inline void report(ViolationKind kind, const char* name) {
+        if (!threadCheck.active)
+            return;
+        auto& v = threadCheck.violations;
+        if (v.first == nullptr)
+            v.first = name;
+        if (kind == Violation_Allocation)
+            v.allocations++;
+        else if (kind == Violation_Lock)
+            v.locks++;
+        else
+            v.systemCalls++;
+        return;
+    }
+
+    // The next definition of name, looked up on first use. dlsym only allocates through glibc's
+    // own malloc, which doesn't come back here.
+    template<typename Function>
+    Function getNext(std::atomic<void*>& slot, const char* name) {
+        auto* function = slot.load(std::memory_order_acquire);
+        if (function == nullptr) {
+            function = dlsym(RTLD_NEXT, name);
+            slot.store(function, std::memory_order_release);
+        }
+        return reinterpret_cast<Function>(function);
+    }
+}
+
+// The slot is constant initialised, so looking it up needs no guard variable either
+#define SIMPLEEQ_NEXT(name) \
+    ([] { static std::atomic<void*> slot {nullptr}; return getNext<decltype(&name)>(slot, #name); }())
+
+// glibc's allocator under its internal names, so the replacements need no lookup at all.
+// Exception specifications follow glibc's declarations.
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+}
+
+//==============================================================================
+extern "C" void* malloc(size_t size) noexcept {
+    report(Violation_Allocation, "malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+    report(Violation_Allocation, "calloc");
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) noexcept {
+    report(Violation_Allocation, "realloc");
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) noexcept {
+    if (pointer != nullptr)
+        report(Violation_Allocation, "free");
+    __libc_free(pointer);
+    return;
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) noexcept {
+    report(Violation_Allocation, "memalign");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    report(Violation_Allocation, "aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    report(Violation_Allocation, "posix_memalign");
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    *result = __libc_memalign(alignment, size);
+    return *result != nullptr || size == 0 ? 0 : ENOMEM;
+}
+
+//==============================================================================
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    report(Violation_Lock, "pthread_mutex_lock");
+    return SIMPLEEQ_NEXT(pthread_mutex_lock)(mutex);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept {
+    report(Violation_Lock, "pthread_rwlock_rdlock");
+    return SIMPLEEQ_NEXT(pthread_rwlock_rdlock)(lock);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept {
+    report(Violation_Lock, "pthread_rwlock_wrlock");
+    return SIMPLEEQ_NEXT(pthread_rwlock_wrlock)(lock);
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex) {
+    report(Violation_Lock, "pthread_cond_wait");
+    return SIMPLEEQ_NEXT(pthread_cond_wait)(condition, mutex);
+}
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time) {
+    report(Violation_Lock, "pthread_cond_timedwait");
+    return SIMPLEEQ_NEXT(pthread_cond_timedwait)(condition, mutex, time);
+}
+
+extern "C" int sem_wait(sem_t* semaphore) {
+    report(Violation_Lock, "sem_wait");
+    return SIMPLEEQ_NEXT(sem_wait)(semaphore);
+}
+
+extern "C" int sem_timedwait(sem_t* semaphore, const struct timespec* time) {
+    report(Violation_Lock, "sem_timedwait");
+    return SIMPLEEQ_NEXT(sem_timedwait)(semaphore, time);
+}
+
+//==============================================================================
+extern "C" ssize_t read(int fd, void* data, size_t size) {
+    report(Violation_SystemCall, "read");
+    return SIMPLEEQ_NEXT(read)(fd, data, size);
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t size) {
+    report(Violation_SystemCall, "write");
+    return SIMPLEEQ_NEXT(write)(fd, data, size);
+}
+
+extern "C" int open(const char* path, int flags, ...) {
+    report(Violation_SystemCall, "open");
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+    return SIMPLEEQ_NEXT(open)(path, flags, mode);
+}
+
+extern "C" int openat(int directory, const char* path, int flags, ...) {
+    report(Violation_SystemCall, "openat");
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+    return SIMPLEEQ_NEXT(openat)(directory, path, flags, mode);
+}
+
+extern "C" int close(int fd) {
+    report(Violation_SystemCall, "close");
+    return SIMPLEEQ_NEXT(close)(fd);
+}
+
+extern "C" int poll(struct pollfd* fds, nfds_t numFds, int timeout) {
+    report(Violation_SystemCall, "poll");
+    return SIMPLEEQ_NEXT(poll)(fds, numFds, timeout);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    report(Violation_SystemCall, "nanosleep");
+    return SIMPLEEQ_NEXT(nanosleep)(duration, remaining);
+}
+
+extern "C" int clock_nanosleep(clockid_t clock, int flags, const struct timespec* time, struct timespec* remaining) {
+    report(Violation_SystemCall, "clock_nanosleep");
+    return SIMPLEEQ_NEXT(clock_nanosleep)(clock, flags, time, remaining);
+}
+
+extern "C" int usleep(useconds_t microseconds) {
+    report(Violation_SystemCall, "usleep");
+    return SIMPLEEQ_NEXT(usleep)(microseconds);
+}
+
+extern "C" int sched_yield() noexcept {
+    report(Violation_SystemCall, "sched_yield");
+    return SIMPLEEQ_NEXT(sched_yield)();
+}
+
+#undef SIMPLEEQ_NEXT
+
+//==============================================================================
+ScopedRealtimeCheck::ScopedRealtimeCheck() {
+    jassert(!threadCheck.active);
+    threadCheck.violations = {};
+    threadCheck.active = true;
+}
+
+ScopedRealtimeCheck::~ScopedRealtimeCheck() {
+    threadCheck.active = false;
+}
+
+RealtimeViolations ScopedRealtimeCheck::getViolations() const {
+    return threadCheck.violations;
+}
+
+bool ScopedRealtimeCheck::isAvailable() {
+    return true;
+}
+
+#else
+
+ScopedRealtimeCheck::ScopedRealtimeCheck() {}
+ScopedRealtimeCheck::~ScopedRealtimeCheck() {}
+
+RealtimeViolations ScopedRealtimeCheck::getViolations() const {
+    return {};
+}
+
+bool ScopedRealtimeCheck::isAvailable() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    Catches allocations, locks and system calls on a thread that must stay
+    real-time safe.
+
+    On Linux with glibc the tools replace malloc and friends and wrap the
+    blocking pthread, semaphore and common system call entry points. The
+    replacements forward to glibc and only count while a
+    ScopedRealtimeCheck is alive on the calling thread, so the rest of the
+    tools run as usual. Elsewhere nothing is counted and isAvailable()
+    says so.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// Jake: What the calling thread did while checked, the name of the first offending call included
+struct RealtimeViolations {
+    int allocations = 0;        // malloc, calloc, realloc, free and the aligned variants
+    int locks = 0;              // blocking mutex, rwlock, condition variable and semaphore waits
+    int systemCalls = 0;        // file and socket I/O, sleeps and yields
+    const char* first = nullptr;
+
+    int getTotal() const { return allocations + locks + systemCalls; }
+};
+
+
+// Jake: Counts violations on the constructing thread until destroyed. Checks don't nest.
+class ScopedRealtimeCheck {
+public:
+    ScopedRealtimeCheck();
+    ~ScopedRealtimeCheck();
+
+    RealtimeViolations getViolations() const;
+
+    static bool isAvailable();
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeCheck)
+};
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    RealtimeTest.cpp
+    Fails on any allocation, lock or system call inside processBlock.
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+#include "../../../Source/PluginProcessor.h"
+
+namespace {
+    constexpr int maxBlockSize = 512;
+
+    const juce::StringArray continuousParameters {"Low-Cut Freq", "High-Cut Freq", "Peak Freq", "Peak Gain", "Peak Quality",
+                                                  "Crossover Freq 1", "Crossover Freq 2", "Crossover Freq 3"};
+    const juce::StringArray choiceParameters {"Low-Cut Slope", "High-Cut Slope", "Low-Cut Type", "High-Cut Type"};
+
+    // Host side of the checks. Everything here may allocate, only processBlock is checked: hosts
+    // set parameters and states between blocks, and what JUCE does for that is out of our hands.
+    class RealtimeTest : public juce::UnitTest {
+    public:
+        RealtimeTest() : juce::UnitTest("Realtime safety", "SimpleEQ") {}
+
+        void runTest() override {
+            if (!ScopedRealtimeCheck::isAvailable()) {
+                logMessage("Realtime checks need Linux with glibc, skipped");
+                return;
+            }
+
+            SimpleEQAudioProcessor processor;
+            prepare(processor, 48000.0);
+
+            beginTest("Steady blocks");
+            for (int block = 0; block < 16; block++) {
+                processChecked(processor, maxBlockSize);
+            }
+
+            beginTest("Automation sweeps");
+            sweepParameters(processor, 256);
+
+            beginTest("Slope and type changes");
+            for (int block = 0; block < 64; block++) {
+                setRandom(processor, choiceParameters[random.nextInt(choiceParameters.size())]);
+                processChecked(processor, maxBlockSize);
+            }
+
+            beginTest("State loads");
+            for (int load = 0; load < 8; load++) {
+                SimpleEQAudioProcessor other;
+                for (const auto& id : continuousParameters) {
+                    setRandom(other, id);
+                }
+                for (const auto& id : choiceParameters) {
+                    setRandom(other, id);
+                }
+                juce::MemoryBlock state;
+                other.getStateInformation(state);
+                processor.setStateInformation(state.getData(), (int)state.getSize());
+                for (int block = 0; block < 4; block++) {
+                    processChecked(processor, maxBlockSize);
+                }
+            }
+
+            beginTest("Sample rate changes");
+            for (const auto sampleRate : {44100.0, 96000.0, 192000.0, 48000.0}) {
+                prepare(processor, sampleRate);
+                for (const auto numSamples : {maxBlockSize, 64, 1, 333}) {
+                    processChecked(processor, numSamples);
+                }
+                sweepParameters(processor, 16);
+            }
+
+            beginTest("Auto gain, soft clip and crossover");
+            setParameter(processor, "Auto Gain", 1.0f);
+            setParameter(processor, "Soft Clip", 1.0f);
+            setParameter(processor, "Crossover Bands", 3.0f);
+            sweepParameters(processor, 64);
+            setParameter(processor, "Crossover Bands", 0.0f);
+
+            beginTest("Match learning");
+            processor.getMatchAnalyser().setLearning(true);
+            sweepParameters(processor, 64);
+            processor.getMatchAnalyser().setLearning(false);
+
+            beginTest("Trace recording");
+            const auto traceFile = juce::File::createTempFile(".seqtrace");
+            expect(processor.getTraceRecorder().start(traceFile));
+            sweepParameters(processor, 64);
+            processor.getTraceRecorder().stop();
+            traceFile.deleteFile();
+            return;
+        }
+
+    private:
+        juce::Random random {1};
+        juce::AudioBuffer<float> buffer {2, maxBlockSize};
+        juce::MidiBuffer midi;
+
+        void prepare(SimpleEQAudioProcessor& processor, double sampleRate) {
+            processor.setPlayConfigDetails(2, 2, sampleRate, maxBlockSize);
+            processor.prepareToPlay(sampleRate, maxBlockSize);
+            return;
+        }
+
+        void setParameter(SimpleEQAudioProcessor& processor, const juce::String& id, float value) {
+            auto* parameter = processor.aptvs.getParameter(id);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            return;
+        }
+
+        void setRandom(SimpleEQAudioProcessor& processor, const juce::String& id) {
+            processor.aptvs.getParameter(id)->setValueNotifyingHost(random.nextFloat());
+            return;
+        }
+
+        // Every continuous parameter moves before each block, so ramps are always in flight
+        void sweepParameters(SimpleEQAudioProcessor& processor, int numBlocks) {
+            for (int block = 0; block < numBlocks; block++) {
+                for (const auto& id : continuousParameters) {
+                    auto* parameter = processor.aptvs.getParameter(id);
+                    const auto phase = (float)block / (float)numBlocks + 0.1f * (float)continuousParameters.indexOf(id);
+                    parameter->setValueNotifyingHost(0.5f + 0.5f * std::sin(juce::MathConstants<float>::twoPi * phase));
+                }
+                processChecked(processor, maxBlockSize);
+            }
+            return;
+        }
+
+        void processChecked(SimpleEQAudioProcessor& processor, int numSamples) {
+            buffer.setSize(2, numSamples, false, false, true);
+            for (int ch = 0; ch < 2; ch++) {
+                for (int i = 0; i < numSamples; i++) {
+                    buffer.setSample(ch, i, 0.5f * (2.0f * random.nextFloat() - 1.0f));
+                }
+            }
+
+            RealtimeViolations violations;
+            {
+                const ScopedRealtimeCheck check;
+                processor.processBlock(buffer, midi);
+                violations = check.getViolations();
+            }
+            expect(violations.getTotal() == 0, juce::String(violations.allocations) + " allocations, " + juce::String(violations.locks) + " locks, "
+                          + juce::String(violations.systemCalls) + " system calls, first " + juce::String(violations.first));
+            return;
+        }
+    };
+
+    static RealtimeTest realtimeTest;
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    ResponseTest.cpp
+    Checks the drawn response against the designed and the rendered one.
+
+  ==============================================================================
+*/
+
+#include "ProcessorRender.h"
+#include "../../../Source/ResponseAnalysis.h"
+
+#include <complex>
+
+namespace {
+    // The response curve draws each band from a MagnitudeEvaluator, clamped to its plot range
+    constexpr double curveFloorDecibels = -100.0;
+    constexpr double curveToleranceDecibels = 1.0e-4;
+    constexpr int curvePoints = 512;
+
+    // The rendered impulse response only has float precision. Above -20 dB it stays within a few
+    // tenths of a dB of the design up to 96 kHz, steep cuts at 192 kHz and filters still ringing
+    // after a second are left to the golden output test.
+    constexpr double renderedMinimumDecibels = -20.0;
+    constexpr double renderedToleranceDecibels = 0.5;
+    constexpr double renderedMaxSampleRate = 96000.0;
+    constexpr float renderedDecayedLevel = 1.0e-6f;
+    constexpr int renderedPoints = 64;
+
+    // Band of coefficients on its own, as ResponseCurve::getBandCoefficients() picks it
+    ChainCoefficients getBand(const ChainCoefficients& coefficients, int band) {
+        ChainCoefficients single;
+        if (band == 0)
+            single.lowCut = coefficients.lowCut;
+        else if (band == 1)
+            single.peak = coefficients.peak;
+        else
+            single.highCut = coefficients.highCut;
+        return single;
+    }
+
+    double getDesignedDecibels(const ChainCoefficients& coefficients, double frequency, double sampleRate) {
+        return juce::Decibels::gainToDecibels(getMagnitudeForFrequency(coefficients, frequency, sampleRate), -200.0);
+    }
+
+    // DFT of the impulse response at one frequency
+    double getRenderedDecibels(const std::vector<float>& impulseResponse, double frequency, double sampleRate) {
+        const auto step = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        std::complex<double> rotation = 1.0, sum = 0.0;
+        for (const auto sample : impulseResponse) {
+            sum += (double)sample * rotation;
+            rotation *= step;
+        }
+        return juce::Decibels::gainToDecibels(std::abs(sum), -200.0);
+    }
+
+    bool hasDecayed(const std::vector<float>& impulseResponse) {
+        const auto tail = impulseResponse.size() / 10;
+        for (auto i = impulseResponse.size() - tail; i < impulseResponse.size(); i++) {
+            if (std::abs(impulseResponse[i]) > renderedDecayedLevel)
+                return false;
+        }
+        return true;
+    }
+
+    class ResponseTest : public juce::UnitTest {
+    public:
+        ResponseTest() : juce::UnitTest("Response", "SimpleEQ") {}
+
+        void runTest() override {
+            const auto cases = makeGoldenCases();
+
+            beginTest("Response curve magnitudes");
+            const auto grid = makeLogFrequencyGrid(curvePoints);
+            std::vector<double> band(grid.size()), total(grid.size());
+            for (const auto& goldenCase : cases) {
+                const auto coefficients = makeChainCoefficients(goldenCase.settings, goldenCase.sampleRate);
+                MagnitudeEvaluator evaluator;
+                evaluator.prepare(grid, goldenCase.sampleRate);
+                std::fill(total.begin(), total.end(), 0.0);
+                for (int b = 0; b < 3; b++) {
+                    evaluator.getDecibels(getBand(coefficients, b), band.data());
+                    for (size_t i = 0; i < grid.size(); i++) {
+                        total[i] += band[i];
+                    }
+                }
+
+                double worst = 0.0;
+                for (size_t i = 0; i < grid.size(); i++) {
+                    const auto expected = juce::jmax(curveFloorDecibels, getDesignedDecibels(coefficients, grid[i], goldenCase.sampleRate));
+                    worst = juce::jmax(worst, std::abs(juce::jmax(curveFloorDecibels, total[i]) - expected));
+                }
+                expect(worst <= curveToleranceDecibels, goldenCase.name + " curve off by " + juce::String(worst, 6) + " dB");
+            }
+
+            beginTest("Rendered impulse responses");
+            const auto renderedGrid = makeLogFrequencyGrid(renderedPoints);
+            for (const auto& goldenCase : cases) {
+                if (goldenCase.sampleRate > renderedMaxSampleRate)
+                    continue;
+                const auto impulseResponse = renderTestSignal(goldenCase, TestSignal_Impulse)[0];
+                if (!hasDecayed(impulseResponse))
+                    continue;
+
+                const auto coefficients = makeChainCoefficients(goldenCase.settings, goldenCase.sampleRate);
+                double worst = 0.0;
+                for (const auto frequency : renderedGrid) {
+                    const auto expected = getDesignedDecibels(coefficients, frequency, goldenCase.sampleRate);
+                    if (expected < renderedMinimumDecibels)
+                        continue;
+                    worst = juce::jmax(worst, std::abs(getRenderedDecibels(impulseResponse, frequency, goldenCase.sampleRate) - expected));
+                }
+                expect(worst <= renderedToleranceDecibels, goldenCase.name + " rendered off by " + juce::String(worst, 3) + " dB");
+            }
+            return;
+        }
+    };
+
+    static ResponseTest responseTest;
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    SoftClipperTest.cpp
+    The ADAA soft clip kernel against a double precision reference.
+
+  ==============================================================================
+*/
+
+#include "../../../Source/SoftClipper.h"
+
+namespace {
+    constexpr int numSamples = 1 << 16;
+    constexpr double tolerance = 1.0e-5;   // float rounding of the divided difference, up to about 5e-6
+
+    double curve(double x) {
+        const auto c = juce::jlimit(-1.5, 1.5, x);
+        return c - 4.0 / 27.0 * c * c * c;
+    }
+
+    double antiderivative(double x) {
+        const auto a = std::abs(x);
+        if (a <= 1.5)
+            return 0.5 * x * x - x * x * x * x / 27.0;
+        return 0.9375 + (a - 1.5);
+    }
+
+    double referenceAdaa(double x, double previous) {
+        if (std::abs(x - previous) < 1.0e-9)
+            return curve(0.5 * (x + previous));
+        return (antiderivative(x) - antiderivative(previous)) / (x - previous);
+    }
+
+    class SoftClipperTest : public juce::UnitTest {
+    public:
+        SoftClipperTest() : juce::UnitTest("Soft clipper", "SimpleEQ") {}
+
+        void runTest() override {
+            juce::Random random {1};
+            std::vector<float> input((size_t)numSamples), output, scratch((size_t)numSamples);
+
+            // Up to 12 dB past full scale, every fourth step tiny so the midpoint fallback runs too
+            for (int i = 0; i < numSamples; i++) {
+                input[(size_t)i] = 4.0f * (2.0f * random.nextFloat() - 1.0f);
+            }
+            for (int i = 0; i + 1 < numSamples; i += 4) {
+                input[(size_t)i + 1] = input[(size_t)i] + 1.0e-4f * (float)(i % 7);
+            }
+
+            beginTest("Matches the double precision ADAA");
+            {
+                output = input;
+                auto previous = input[0];
+                processSoftClip(output.data(), previous, scratch.data(), numSamples);
+
+                auto worst = 0.0, peak = 0.0;
+                for (int i = 1; i < numSamples; i++) {
+                    worst = juce::jmax(worst, std::abs(output[(size_t)i] - referenceAdaa(input[(size_t)i], input[(size_t)i - 1])));
+                    peak = juce::jmax(peak, (double)std::abs(output[(size_t)i]));
+                }
+                expectLessThan(worst, tolerance);
+                expectLessOrEqual(peak, 1.0);
+                expectEquals(previous, input[(size_t)numSamples - 1]);
+            }
+
+            beginTest("Block size doesn't change the output");
+            {
+                std::vector<float> whole = input, split = input;
+                auto previousWhole = 0.0f, previousSplit = 0.0f;
+                processSoftClip(whole.data(), previousWhole, scratch.data(), numSamples);
+                for (int start = 0, size = 1; start < numSamples; start += size, size = size % 509 + 37) {
+                    const auto count = juce::jmin(size, numSamples - start);
+                    processSoftClip(split.data() + start, previousSplit, scratch.data(), count);
+                }
+                expect(whole == split);
+            }
+            return;
+        }
+    };
+
+    static SoftClipperTest softClipperTest;
+}
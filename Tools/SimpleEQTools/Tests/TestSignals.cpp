@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    TestSignals.cpp
+    Deterministic test signals and the golden output fingerprints of SimpleEQ.
+
+  ==============================================================================
+*/
+
+#include "TestSignals.h"
+
+#include <cmath>
+
+namespace {
+    constexpr float signalAmplitude = 0.5f;
+    constexpr double sweepStartFrequency = 20.0;
+    constexpr double sweepEndFrequency = 20000.0;
+
+    // RMS of data in dB, floored so silence still has a comparable value
+    double getLevelDecibels(const float* data, int numSamples) {
+        double sum = 0.0;
+        for (int i = 0; i < numSamples; i++) {
+            sum += (double)data[i] * (double)data[i];
+        }
+        const auto rms = numSamples > 0 ? std::sqrt(sum / numSamples) : 0.0;
+        return juce::Decibels::gainToDecibels(rms, GoldenFingerprint::floorDecibels);
+    }
+
+    // Appends the level of numSegments equal parts of data
+    void addSegmentLevels(const std::vector<float>& data, int numSegments, std::vector<double>& values) {
+        const auto length = (int)data.size();
+        for (int s = 0; s < numSegments; s++) {
+            const auto start = s * length / numSegments;
+            const auto end = (s + 1) * length / numSegments;
+            values.push_back(getLevelDecibels(data.data() + start, end - start));
+        }
+        return;
+    }
+
+    ChainSettings makeBaseSettings() {
+        ChainSettings settings;
+        settings.lowCutFreq = 100.0f;
+        settings.highCutFreq = 8000.0f;
+        settings.peakFreq = 1000.0f;
+        settings.peakGainInDecibels = 6.0f;
+        settings.peakQuality = 1.0f;
+        return settings;
+    }
+
+    juce::String getSlopeName(Slope slope) {
+        return juce::String(6 * ((int)slope + 1));
+    }
+}
+
+//==============================================================================
+int getTestSignalLength(TestSignal signal, double sampleRate) {
+    const auto seconds = signal == TestSignal_Sweep ? 2.0 : 1.0;
+    return (int)std::round(seconds * sampleRate);
+}
+
+
+void makeTestSignal(TestSignal signal, int channel, double sampleRate, float* data, int numSamples) {
+    if (signal == TestSignal_Impulse) {
+        for (int i = 0; i < numSamples; i++) {
+            data[i] = i == 0 ? 1.0f : 0.0f;
+        }
+    }
+    else if (signal == TestSignal_Sweep) {
+        // Exponential sweep, the phase is the integral of a frequency rising by equal ratios
+        const auto duration = getTestSignalLength(TestSignal_Sweep, sampleRate) / sampleRate;
+        const auto logRatio = std::log(sweepEndFrequency / sweepStartFrequency);
+        for (int i = 0; i < numSamples; i++) {
+            const auto t = i / sampleRate;
+            const auto phase = juce::MathConstants<double>::twoPi * sweepStartFrequency * duration / logRatio
+                             * (std::exp(t * logRatio / duration) - 1.0);
+            data[i] = signalAmplitude * (float)std::sin(phase);
+        }
+    }
+    else {
+        // xorshift32 instead of juce::Random, so the sequence is pinned down here
+        juce::uint32 state = 0x12345678u + 0x9e3779b9u * (juce::uint32)channel;
+        for (int i = 0; i < numSamples; i++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            data[i] = signalAmplitude * (float)((double)(state >> 8) / 8388608.0 - 1.0);
+        }
+    }
+    return;
+}
+
+
+std::vector<GoldenCase> makeGoldenCases() {
+    const std::array<double, 4> sampleRates {44100.0, 48000.0, 96000.0, 192000.0};
+    std::vector<GoldenCase> cases;
+
+    for (const auto sampleRate : sampleRates) {
+        const auto rateName = juce::String((int)sampleRate);
+        for (int slope = 0; slope < NumSlopes; slope++) {
+            auto settings = makeBaseSettings();
+            settings.lowCutSlope = (Slope)slope;
+            settings.highCutSlope = (Slope)slope;
+            cases.push_back({"slope_" + getSlopeName((Slope)slope) + "_" + rateName, settings, sampleRate});
+        }
+    }
+
+    const std::array<const char*, NumCutTypes> typeNames {"butterworth", "linkwitzriley", "bessel", "chebyshev"};
+    for (int type = 0; type < NumCutTypes; type++) {
+        for (const auto slope : {Slope_6, Slope_48, Slope_96}) {
+            auto settings = makeBaseSettings();
+            settings.lowCutSlope = slope;
+            settings.highCutSlope = slope;
+            settings.lowCutType = (CutType)type;
+            settings.highCutType = (CutType)type;
+            cases.push_back({juce::String("type_") + typeNames[(size_t)type] + "_" + getSlopeName(slope) + "_48000", settings, 48000.0});
+        }
+    }
+
+    // Ends of every parameter range, the cuts at their steepest where they matter
+    for (const auto sampleRate : sampleRates) {
+        const auto rateName = juce::String((int)sampleRate);
+        auto add = [&](const char* name, auto&& change) {
+            auto settings = makeBaseSettings();
+            change(settings);
+            cases.push_back({juce::String(name) + "_" + rateName, settings, sampleRate});
+        };
+        add("peak_max", [](ChainSettings& s) { s.peakGainInDecibels = 24.0f; s.peakQuality = 10.0f; });
+        add("peak_min", [](ChainSettings& s) { s.peakGainInDecibels = -24.0f; s.peakQuality = 0.1f; });
+        add("peak_lowest", [](ChainSettings& s) { s.peakFreq = 20.0f; s.peakGainInDecibels = 24.0f; s.peakQuality = 10.0f; });
+        add("peak_highest", [](ChainSettings& s) { s.peakFreq = 20000.0f; s.peakGainInDecibels = -24.0f; s.peakQuality = 10.0f; });
+        add("cuts_open", [](ChainSettings& s) {
+            s.lowCutFreq = 20.0f; s.highCutFreq = 20000.0f; s.peakGainInDecibels = 0.0f;
+            s.lowCutSlope = Slope_96; s.highCutSlope = Slope_96;
+            s.lowCutType = CutType_Chebyshev; s.highCutType = CutType_Chebyshev;
+        });
+        add("cuts_closed", [](ChainSettings& s) {
+            s.lowCutFreq = 20000.0f; s.highCutFreq = 20.0f;
+            s.lowCutSlope = Slope_96; s.highCutSlope = Slope_96;
+        });
+    }
+    return cases;
+}
+
+
+//==============================================================================
+std::vector<double> GoldenFingerprint::make(const RenderedSignals& rendered) {
+    std::vector<double> values;
+    values.reserve((size_t)numValues);
+
+    const auto& impulse = rendered[TestSignal_Impulse][0];
+    for (int i = 0; i < numImpulseSamples; i++) {
+        values.push_back(i < (int)impulse.size() ? (double)impulse[(size_t)i] : 0.0);
+    }
+
+    // Energy rather than level, so the value doesn't depend on the signal length
+    double energy = 0.0;
+    for (const auto sample : impulse) {
+        energy += (double)sample * (double)sample;
+    }
+    values.push_back(juce::jmax(floorDecibels, 10.0 * std::log10(juce::jmax(energy, 1.0e-30))));
+
+    addSegmentLevels(rendered[TestSignal_Sweep][0], numSweepSegments, values);
+    addSegmentLevels(rendered[TestSignal_Noise][0], numNoiseSegments, values);
+    addSegmentLevels(rendered[TestSignal_Noise][1], numNoiseSegments, values);
+    return values;
+}
+
+
+bool GoldenFingerprint::matches(int index, double expected, double expectedNoise, double actual) {
+    if (index < numImpulseSamples)
+        return std::abs(actual - expected) <= 1.0e-5 + 1.0e-4 * std::abs(expected) + noiseAllowance * std::abs(expectedNoise);
+
+    // Steep cuts at low frequencies can leave whole parts of the output to rounding, there and deep
+    // in the stop bands no two builds need to agree
+    if (expected < ignoredDecibels && actual < ignoredDecibels)
+        return true;
+    const auto signalToNoise = expected - expectedNoise;
+    if (signalToNoise < minSignalToNoiseDecibels)
+        return true;
+
+    // Noise at that ratio to the signal moves its level by at most this much
+    const auto noiseRatio = noiseAllowance * juce::Decibels::decibelsToGain(-signalToNoise, -1000.0);
+    return std::abs(actual - expected) <= levelToleranceDecibels + juce::Decibels::gainToDecibels(1.0 + noiseRatio);
+}
+
+
+//==============================================================================
+juce::String formatGoldenLine(const juce::String& name, const std::vector<double>& values, const std::vector<double>& noise) {
+    auto line = name;
+    for (const auto* fingerprint : {&values, &noise}) {
+        for (const auto value : *fingerprint) {
+            line << "," << juce::String(value, 9, true);
+        }
+    }
+    return line;
+}
+
+
+std::map<juce::String, std::vector<double>> parseGoldenFile(const juce::String& text) {
+    std::map<juce::String, std::vector<double>> fingerprints;
+    for (const auto& line : juce::StringArray::fromLines(text)) {
+        const auto trimmed = line.trim();
+        if (trimmed.isEmpty() || trimmed.startsWithChar('#'))
+            continue;
+
+        const auto tokens = juce::StringArray::fromTokens(trimmed, ",", "");
+        auto& values = fingerprints[tokens[0].trim()];
+        for (int i = 1; i < tokens.size(); i++) {
+            values.push_back(tokens[i].trim().getDoubleValue());
+        }
+    }
+    return fingerprints;
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+    Deterministic test signals and the golden output fingerprints of SimpleEQ.
+
+    The signals are generated from plain integer and double math so they
+    come out the same on every platform. A fingerprint condenses what the
+    processor made of them into a few numbers per case, which are compared
+    with GoldenOutput.csv within tolerances scaled by the rounding noise
+    stored with them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/EQDesign.h"
+
+#include <array>
+#include <map>
+#include <vector>
+
+
+// Jake: Signals rendered through the processor, all of them on both channels
+enum TestSignal {
+    TestSignal_Impulse,     // 1 at the first sample, 1 second
+    TestSignal_Sweep,       // exponential sine sweep 20 Hz to 20 kHz at 0.5, 2 seconds
+    TestSignal_Noise,       // uniform white noise at 0.5, a different sequence per channel, 1 second
+    NumTestSignals
+};
+
+int getTestSignalLength(TestSignal signal, double sampleRate);
+void makeTestSignal(TestSignal signal, int channel, double sampleRate, float* data, int numSamples);
+
+// Jake: Output of one signal, channel 0 and 1
+using RenderedSignal = std::array<std::vector<float>, 2>;
+using RenderedSignals = std::array<RenderedSignal, NumTestSignals>;
+
+
+// Jake: One configuration the golden data covers, the name is the key in GoldenOutput.csv
+struct GoldenCase {
+    juce::String name;
+    ChainSettings settings;
+    double sampleRate = 48000.0;
+};
+
+// Jake: Every slope at 44.1 to 192 kHz, every cut type at 48 kHz and the parameter extremes at
+// every rate
+std::vector<GoldenCase> makeGoldenCases();
+
+
+// Jake: Layout of a fingerprint. The golden data also holds the fingerprint of the float rounding
+// noise of the build that wrote it, its output minus a double precision render. Other builds round
+// differently by up to noiseAllowance times as much, so every tolerance widens by that much noise
+// and levels that close to it are skipped.
+struct GoldenFingerprint {
+    static constexpr int numImpulseSamples = 16;    // first samples of the impulse response, channel 0
+    static constexpr int numSweepSegments = 32;     // RMS of equal parts of the sweep, channel 0
+    static constexpr int numNoiseSegments = 4;      // RMS of equal parts of the noise, per channel
+
+    static constexpr int impulseEnergyIndex = numImpulseSamples;
+    static constexpr int sweepIndex = impulseEnergyIndex + 1;
+    static constexpr int noiseIndex = sweepIndex + numSweepSegments;
+    static constexpr int numValues = noiseIndex + 2 * numNoiseSegments;
+
+    static constexpr double floorDecibels = -160.0;
+    static constexpr double ignoredDecibels = -120.0;        // below this both only need to be quiet
+    static constexpr double noiseAllowance = 4.0;
+    static constexpr double levelToleranceDecibels = 0.05;   // on top of what the noise allows
+    static constexpr double minSignalToNoiseDecibels = 20.0; // levels closer to the noise are skipped
+
+    static std::vector<double> make(const RenderedSignals& rendered);
+    static bool matches(int index, double expected, double expectedNoise, double actual);
+};
+
+
+// Jake: GoldenOutput.csv is one line per case, the name followed by its fingerprint values and the
+// values of its noise fingerprint
+juce::String formatGoldenLine(const juce::String& name, const std::vector<double>& values, const std::vector<double>& noise);
+std::map<juce::String, std::vector<double>> parseGoldenFile(const juce::String& text);
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    TraceRecorderTest.cpp
+    Starting and stopping traces while the audio thread keeps recording.
+
+  ==============================================================================
+*/
+
+#include "../../../Source/TraceRecorder.h"
+
+#include <thread>
+
+namespace {
+    constexpr int numRecordings = 40;
+
+    class TraceRecorderTest : public juce::UnitTest {
+    public:
+        TraceRecorderTest() : juce::UnitTest("Trace recorder", "SimpleEQ") {}
+
+        void runTest() override {
+            juce::AudioParameterFloat frequency {juce::ParameterID {"Peak Freq", 1}, "Peak Freq", 20.0f, 20000.0f, 750.0f};
+            juce::AudioParameterFloat gain {juce::ParameterID {"Peak Gain", 1}, "Peak Gain", -24.0f, 24.0f, 0.0f};
+            TraceRecorder recorder;
+            recorder.watchParameters({&frequency, &gain});
+            recorder.prepare(48000.0);
+
+            // Blocks of an audio thread that never waits for the message thread
+            std::atomic<bool> shouldExit {false};
+            std::thread audioThread([&] {
+                juce::Random random {1};
+                while (!shouldExit.load()) {
+                    ScopedTraceEvent block(recorder, TraceEvent_Block, 64);
+                    recorder.beginBlock();
+                    if (random.nextInt(4) == 0)
+                        frequency.setValueNotifyingHost(random.nextFloat());
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            });
+
+            beginTest("Restarts while the audio thread runs");
+            juce::Random random {2};
+            const auto file = juce::File::createTempFile(".seqtrace");
+            for (int recording = 0; recording < numRecordings; recording++) {
+                expect(recorder.start(file));
+                juce::Thread::sleep(random.nextInt(5));
+                recorder.stop();
+
+                // Every trace starts over with a full set of parameter values, nothing left from the one before
+                const auto trace = readTraceFile(file);
+                expect(trace.has_value(), "reading trace " + juce::String(recording));
+                if (!trace.has_value() || trace->records.empty())
+                    continue;
+
+                const auto& records = trace->records;
+                expect(records.size() >= 2 && records[0].type == TraceEvent_ParameterChange && records[0].index == 0
+                       && records[1].type == TraceEvent_ParameterChange && records[1].index == 1,
+                       "trace " + juce::String(recording) + " starts with every parameter");
+                const auto hasStray = std::any_of(records.begin(), records.end(), [] (const TraceRecord& record) {
+                    return record.ticks < 0 || record.type >= NumTraceEventTypes;
+                });
+                expect(!hasStray, "trace " + juce::String(recording) + " has no stray records");
+            }
+
+            shouldExit.store(true);
+            audioThread.join();
+            file.deleteFile();
+            return;
+        }
+    };
+
+    static TraceRecorderTest traceRecorderTest;
+}